@@ -1,5 +1,6 @@
 from hello_world.hello_world import hello_world
 from hello_world_uart.hello_world_uart import hello_world_uart
 from user_proj_tests.spi_uart_integration.spi_uart_integration import spi_uart_basic, spi_uart_wishbone, spi_uart_interrupts, spi_uart_gpio_control, spi_uart_logic_analyzer
-from user_proj_tests.spi_uart_wishbone.spi_uart_wishbone import spi_uart_wishbone_basic, spi_uart_wishbone_registers, spi_uart_wishbone_data_transfer
+from user_proj_tests.spi_uart_wishbone.spi_uart_wishbone import spi_uart_wishbone_basic, spi_uart_wishbone_registers, spi_uart_wishbone_data_transfer, spi_uart_wishbone_dma, spi_uart_wishbone_perf, spi_uart_wishbone_trace, spi_uart_wishbone_iov, spi_uart_wishbone_spi_slave, spi_uart_wishbone_autobaud, spi_uart_wishbone_crc, spi_uart_wishbone_framing, spi_uart_wishbone_snapshot, spi_uart_wishbone_clkgate, spi_uart_wishbone_la_mailbox
+from user_proj_tests.spi_uart_bench.spi_uart_bench import spi_uart_bench_spi, spi_uart_bench_uart, spi_uart_bench_wb_latency, spi_uart_bench_irq_latency
 from gpio_test.gpio_test import gpio_test
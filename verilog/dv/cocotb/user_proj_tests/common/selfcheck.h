@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+// Pass/fail report for self-checking firmware.
+//
+// The firmware counts its own errors and ends with UserTest_finish():
+// debug_reg1 gets the pass or fail code, then the management GPIO drops.
+// run_selfcheck() in common/selfcheck.py waits for that edge and checks
+// the code.
+
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+#define USER_TEST_PASS  0x1B
+#define USER_TEST_FAIL  0x1E
+
+static inline void UserTest_report(int errors){
+    set_debug_reg1(errors == 0 ? USER_TEST_PASS : USER_TEST_FAIL);
+}
+
+static inline void UserTest_finish(int errors){
+    UserTest_report(errors);
+    ManagmentGpio_write(0); // test finished
+}
+
+#endif // SELFCHECK_H
@@ -0,0 +1,65 @@
+# SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#      http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# SPDX-License-Identifier: Apache-2.0
+
+"""Self-checking firmware tests.
+
+The firmware raises the management GPIO once the pads are configured,
+checks its own results and ends with UserTest_finish() (selfcheck.h),
+which puts PASS_CODE or FAIL_CODE in debug_reg1 and drops the GPIO.
+"""
+
+from caravel_cocotb.caravel_interfaces import test_configure
+import cocotb
+
+PASS_CODE = 0x1B
+FAIL_CODE = 0x1E
+
+
+def check_pass_code(caravelEnv, what):
+    """Log an error unless the firmware reported PASS_CODE"""
+    result = caravelEnv.read_debug_reg1()
+    if result != PASS_CODE:
+        cocotb.log.error(f"[TEST] {what} failed, firmware reported {result:02x}")
+    return result == PASS_CODE
+
+
+async def run_selfcheck(dut, name, what, pins=(), during=None, timeout_cycles=10000000):
+    """Run the firmware for test `name` and check its pass code.
+
+    pins are (gpio, value) pairs driven before the firmware starts.
+    during(caravelEnv), if given, runs from the end of configuration
+    until the firmware finishes, for stimulus and monitors; it is
+    killed if it is still running then. Returns the environment so
+    the caller can check what `during` collected.
+    """
+    caravelEnv = await test_configure(dut, timeout_cycles=timeout_cycles)
+
+    cocotb.log.info(f"[TEST] Start {name} test")
+
+    for pin, value in pins:
+        caravelEnv.drive_gpio_in((pin, pin), value)
+
+    await caravelEnv.release_csb()
+    await caravelEnv.wait_mgmt_gpio(1)
+
+    task = cocotb.start_soon(during(caravelEnv)) if during is not None else None
+    await caravelEnv.wait_mgmt_gpio(0)
+    if task is not None and not task.done():
+        task.kill()
+
+    check_pass_code(caravelEnv, what)
+    cocotb.log.info(f"[TEST] {what} test completed")
+    return caravelEnv
@@ -0,0 +1,600 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+// Interrupt-driven driver for the user project SPI (0x0000) and UART
+// (0x1000) windows.
+//
+// Each direction has a single-producer/single-consumer ring. The ISR is
+// the producer of the RX rings and the consumer of the TX rings; the
+// application is the other side. Each index is written by one side only,
+// so no locking is needed as long as UserSpiUart_isr() is not re-entered.
+//
+// The TX interrupt (FIFO below threshold) is enabled by the application
+// after it queues data and disabled by the ISR when the ring runs dry.
+// If the two race, the worst case is one spurious interrupt with nothing
+// to send.
+//
+// Call UserSpiUart_isr() from the handler for irq[0]/irq[1], or from a
+// loop that watches UART_IRQ (0xF00C) and the SPI status.
+//
+// The *_writev/*_readv/UserSpi_xferv calls are polled scatter-gather
+// transfers that move caller-owned buffers straight through the FIFOs in
+// bursts, with one level read per burst instead of a status check per
+// byte. Do not mix them with the ring API on the same direction while
+// the ISR is active.
+
+#ifndef SPI_UART_DRV_H
+#define SPI_UART_DRV_H
+
+#include <stdint.h>
+
+// Ring size in bytes (power of two)
+#ifndef SPI_UART_RING_SIZE
+#define SPI_UART_RING_SIZE  64
+#endif
+
+// FIFO depth of the CF IPs, from their FAW parameter. One slot is kept
+// free when filling, as the DMA engine and the bridge do.
+#define SPI_UART_FAW        4
+#define SPI_UART_FIFO_DEPTH (1 << SPI_UART_FAW)
+#define SPI_UART_FIFO_ROOM  (SPI_UART_FIFO_DEPTH - 1)
+
+#define USER_BASE_ADDR      0x30000000
+#define USER_SPI_BASE       (USER_BASE_ADDR + 0x0000)
+#define USER_UART_BASE      (USER_BASE_ADDR + 0x1000)
+#define USER_UART_CHAN_BASE(i) (USER_BASE_ADDR + ((i) ? 0x3000 + (i) * 0x1000 : 0x1000))
+#define USER_BAUD_BASE      (USER_BASE_ADDR + 0xF100)
+#define USER_CRC_BASE       (USER_BASE_ADDR + 0xF120)
+#define USER_FRM_BASE       (USER_BASE_ADDR + 0xF140)
+#define USER_CTRL_BASE      (USER_BASE_ADDR + 0xF000)
+
+// Control register block
+#define CTRL_STATUS         0x00
+#define CTRL_CONTROL        0x04
+#define CTRL_SNAPSHOT       0x40
+#define CTRL_STATUS_POLL    (1 << 3)
+#define CTRL_SPI_CLK_GATE   (1 << 4)
+#define CTRL_UART_CLK_GATE  (1 << 5)
+#define CTRL_CLK_IDLE(n)    ((n) << 12)   // 2^(n+4) user_clock2 cycles
+#define CTRL_CLK_IDLE_MASK  CTRL_CLK_IDLE(0xF)
+#define CTRL_LA_MAILBOX     (1 << 8)
+#define STATUS_SPI_CLK_OFF  (1 << 4)
+#define STATUS_UART_CLK_OFF (1 << 5)
+
+// LA mailbox requests (reg_la0_oenb[7:0]) and response (reg_la3_data_in)
+#define LAM_PUSH            0x01
+#define LAM_POP             0x02
+#define LAM_PUSH_UART       0x04
+#define LAM_POP_UART        0x08
+#define LAM_PUSH_LEN(n)     (((n) - 1) << 4)
+#define LAM_REQ_MASK        0xFF
+#define LAM_POP_COUNT(w)    (((w) >> 24) & 0xF)
+#define LAM_POP_ACK         (1u << 30)
+#define LAM_PUSH_ACK        (1u << 31)
+#define LAM_POP_MAX         15
+
+// SNAPSHOT fields. A level of 16 (bit 4 set) means the FIFO is full.
+#define SNAP_SPI_RX_LEVEL(s)    ((s) & 0x1F)
+#define SNAP_SPI_TX_LEVEL(s)    (((s) >> 5) & 0x1F)
+#define SNAP_UART_RX_LEVEL(s)   (((s) >> 10) & 0x1F)
+#define SNAP_UART_TX_LEVEL(s)   (((s) >> 15) & 0x1F)
+#define SNAP_UART_FE        (1u << 20)
+#define SNAP_UART_PE        (1u << 21)
+#define SNAP_UART_OR        (1u << 22)
+#define SNAP_UART_BRK       (1u << 23)
+#define SNAP_SSLV_OVERRUN   (1u << 24)
+#define SNAP_SSLV_UNDERRUN  (1u << 25)
+#define SNAP_IRQ_SPI        (1u << 26)
+#define SNAP_IRQ_UART0      (1u << 27)
+#define SNAP_IRQ_UARTX      (1u << 28)
+#define SNAP_IRQ_FRM        (1u << 29)
+#define SNAP_IRQ_DMA        (1u << 30)
+#define SNAP_VALID          (1u << 31)
+
+// Register offsets shared by the CF IP windows (0xE00-0xFFF reach the
+// IP offsets 0xFE00-0xFFFF)
+#define CF_RXDATA           0x000
+#define CF_TXDATA           0x004
+#define CF_RX_FIFO_LEVEL    0xE00
+#define CF_RX_FIFO_THRESH   0xE04
+#define CF_TX_FIFO_LEVEL    0xE10
+#define CF_TX_FIFO_THRESH   0xE14
+#define CF_IM               0xF00
+#define CF_MIS              0xF04
+#define CF_RIS              0xF08
+#define CF_IC               0xF0C
+#define CF_GCLK             0xF10
+
+// UART registers and interrupt flags
+#define UART_PR             0x008
+#define UART_CTRL           0x00C
+#define UART_CTRL_EN        0x01
+#define UART_CTRL_TXEN      0x02
+#define UART_CTRL_RXEN      0x04
+#define UART_CTRL_LPEN      0x08
+#define UART_IRQ_TXB        (1 << 2)  // TX FIFO level below threshold
+#define UART_IRQ_RXA        (1 << 3)  // RX FIFO level above threshold
+#define UART_IRQ_OR         (1 << 8)  // RX overrun
+
+// UART channel 0 baud generator
+#define BAUD_CTRL           0x00
+#define BAUD_FRAC           0x04
+#define BAUD_STATUS         0x08
+#define BAUD_MEAS           0x0C
+#define BAUD_CTRL_FRAC_EN   0x01
+#define BAUD_CTRL_AUTO      0x02
+#define BAUD_STATUS_BUSY    0x01
+#define BAUD_STATUS_DONE    0x02
+#define BAUD_STATUS_ERROR   0x04
+
+// CRC engine. Channels: 0 SPI TX, 1 SPI RX, 2 UART TX, 3 UART RX
+#define CRC_CTRL            0x00
+#define CRC_POLY            0x04
+#define CRC_INIT            0x08
+#define CRC_XOROUT          0x0C
+#define CRC_VALUE(ch)       (0x10 + 4 * (ch))
+#define CRC_CTRL_SIZE32     0x01
+#define CRC_CTRL_REFIN      0x02
+#define CRC_CTRL_REFOUT     0x04
+#define CRC_CTRL_EN(ch)     (1 << (4 + (ch)))
+#define CRC_CTRL_RST(ch)    (1 << (8 + (ch)))
+#define CRC_CH_SPI_TX       0
+#define CRC_CH_SPI_RX       1
+#define CRC_CH_UART_TX      2
+#define CRC_CH_UART_RX      3
+
+// UART channel 0 framer
+#define FRM_CTRL            0x00
+#define FRM_TXDATA          0x04
+#define FRM_RXDATA          0x08
+#define FRM_RXLEN           0x0C
+#define FRM_STATUS          0x10
+#define FRM_CTRL_EN         0x01
+#define FRM_CTRL_COBS       0x02
+#define FRM_CTRL_IE         0x10
+#define FRM_TX_END          0x100
+#define FRM_RXLEN_ERROR     (1u << 30)
+#define FRM_RXLEN_VALID     (1u << 31)
+#define FRM_STATUS_TX_FULL  (1 << 9)
+#define FRM_STATUS_TX_IDLE  (1 << 10)
+#define FRM_STATUS_TX_OVERFLOW (1 << 11)
+#define FRM_STATUS_FRAME    (1 << 24)
+
+// SPI registers and interrupt flags
+#define SPI_CFG             0x008
+#define SPI_CTRL            0x00C
+#define SPI_PR              0x010
+#define SPI_CTRL_SS         0x01
+#define SPI_CTRL_EN         0x02
+#define SPI_CTRL_RXEN       0x04
+#define SPI_IRQ_TXB         (1 << 4)  // TX FIFO level below threshold
+#define SPI_IRQ_RXA         (1 << 5)  // RX FIFO level above threshold
+
+#define CF_REG(base, off)   (*(volatile uint32_t*)((base) + (off)))
+
+typedef struct {
+    volatile uint8_t data[SPI_UART_RING_SIZE];
+    volatile uint32_t head; // written by the producer only
+    volatile uint32_t tail; // written by the consumer only
+} UserRing;
+
+typedef struct {
+    uint32_t base;
+    uint32_t irq_txb;
+    uint32_t irq_rxa;
+    volatile uint32_t im;   // shadow of IM
+    UserRing tx;
+    UserRing rx;
+    volatile uint32_t rx_dropped;
+} UserSerialDev;
+
+static UserSerialDev user_spi_dev = { USER_SPI_BASE, SPI_IRQ_TXB, SPI_IRQ_RXA };
+static UserSerialDev user_uart_dev = { USER_UART_BASE, UART_IRQ_TXB, UART_IRQ_RXA };
+
+// Ring helpers. Indices run freely and wrap at 2^32; the slot is the low
+// bits, so a full ring is head - tail == SPI_UART_RING_SIZE.
+static inline uint32_t UserRing_used(UserRing *r){
+    return r->head - r->tail;
+}
+
+static inline uint32_t UserRing_free(UserRing *r){
+    return SPI_UART_RING_SIZE - (r->head - r->tail);
+}
+
+static inline void UserRing_put(UserRing *r, uint8_t b){
+    r->data[r->head & (SPI_UART_RING_SIZE - 1)] = b;
+    r->head = r->head + 1; // publish after the slot is written
+}
+
+static inline uint8_t UserRing_get(UserRing *r){
+    uint8_t b = r->data[r->tail & (SPI_UART_RING_SIZE - 1)];
+    r->tail = r->tail + 1; // release after the slot is read
+    return b;
+}
+
+// Device level
+static void UserSerial_start(UserSerialDev *d){
+    d->tx.head = d->tx.tail = 0;
+    d->rx.head = d->rx.tail = 0;
+    d->rx_dropped = 0;
+
+    CF_REG(d->base, CF_GCLK) = 1;
+    CF_REG(d->base, CF_RX_FIFO_THRESH) = 0;                        // any byte
+    CF_REG(d->base, CF_TX_FIFO_THRESH) = SPI_UART_FIFO_DEPTH / 2;  // refill at half
+    CF_REG(d->base, CF_IC) = 0xFFFFFFFF;
+
+    d->im = d->irq_rxa;
+    CF_REG(d->base, CF_IM) = d->im;
+}
+
+// Move bytes between the FIFOs and the rings. ISR context only.
+static void UserSerial_service(UserSerialDev *d){
+    uint32_t mis = CF_REG(d->base, CF_MIS);
+
+    if (mis & d->irq_rxa) {
+        uint32_t level = CF_REG(d->base, CF_RX_FIFO_LEVEL);
+        while (level--) {
+            uint8_t b = CF_REG(d->base, CF_RXDATA);
+            if (UserRing_free(&d->rx))
+                UserRing_put(&d->rx, b);
+            else
+                d->rx_dropped++;
+        }
+    }
+
+    if (mis & d->irq_txb) {
+        uint32_t room = SPI_UART_FIFO_ROOM - CF_REG(d->base, CF_TX_FIFO_LEVEL);
+        while (room-- && UserRing_used(&d->tx))
+            CF_REG(d->base, CF_TXDATA) = UserRing_get(&d->tx);
+        if (!UserRing_used(&d->tx)) {
+            d->im &= ~d->irq_txb;
+            CF_REG(d->base, CF_IM) = d->im;
+        }
+    }
+
+    CF_REG(d->base, CF_IC) = mis;
+}
+
+static int UserSerial_write(UserSerialDev *d, const uint8_t *buf, int len){
+    int n = 0;
+    while (n < len && UserRing_free(&d->tx))
+        UserRing_put(&d->tx, buf[n++]);
+    if (n) {
+        d->im |= d->irq_txb;
+        CF_REG(d->base, CF_IM) = d->im;
+    }
+    return n;
+}
+
+static int UserSerial_read(UserSerialDev *d, uint8_t *buf, int len){
+    int n = 0;
+    while (n < len && UserRing_used(&d->rx))
+        buf[n++] = UserRing_get(&d->rx);
+    return n;
+}
+
+// Bytes not yet handed to the wire (ring plus TX FIFO); 0 once drained
+static int UserSerial_flush(UserSerialDev *d){
+    if (UserRing_used(&d->tx)) {
+        d->im |= d->irq_txb;
+        CF_REG(d->base, CF_IM) = d->im;
+    }
+    return UserRing_used(&d->tx) + CF_REG(d->base, CF_TX_FIFO_LEVEL);
+}
+
+// UART API. prescaler is written to PR as-is (see the CF_UART datasheet).
+static void UserUart_init(uint32_t prescaler, int loopback){
+    CF_REG(USER_UART_BASE, UART_CTRL) = 0;
+    CF_REG(USER_UART_BASE, UART_PR) = prescaler;
+    UserSerial_start(&user_uart_dev);
+    CF_REG(USER_UART_BASE, UART_CTRL) = UART_CTRL_EN | UART_CTRL_TXEN | UART_CTRL_RXEN |
+                                        (loopback ? UART_CTRL_LPEN : 0);
+}
+
+// Fractional baud on channel 0: with PR = 0 the bit rate is
+// user_clock2 * (frac + 1) / 2^27. Pass frac = 0 to go back to PR alone.
+static inline void UserUart_setFrac(uint32_t frac){
+    if (frac) {
+        CF_REG(USER_BAUD_BASE, BAUD_FRAC) = frac;
+        CF_REG(USER_BAUD_BASE, BAUD_CTRL) = BAUD_CTRL_FRAC_EN;
+    } else {
+        CF_REG(USER_BAUD_BASE, BAUD_CTRL) = 0;
+    }
+}
+
+// Auto-baud on channel 0: the peer sends 0x55 ('U'). Needs PR = 0. The
+// byte received while timing is garbage and should be discarded. Poll
+// UserUart_autoBaudStatus() until BUSY clears.
+static inline void UserUart_autoBaud(void){
+    CF_REG(USER_UART_BASE, UART_PR) = 0;
+    CF_REG(USER_BAUD_BASE, BAUD_CTRL) = BAUD_CTRL_AUTO;
+}
+
+static inline uint32_t UserUart_autoBaudStatus(void){
+    return CF_REG(USER_BAUD_BASE, BAUD_STATUS);
+}
+
+// Stop a running auto-baud, e.g. when no peer answers. FRAC_EN goes off;
+// DONE and ERROR stay clear. Without an abort, auto-baud gives up with
+// ERROR after 2^24 user_clock2 cycles without an edge.
+static inline void UserUart_autoBaudAbort(void){
+    CF_REG(USER_BAUD_BASE, BAUD_CTRL) = 0;
+}
+
+// Status snapshot. With polling on, each SNAPSHOT read returns the last
+// poll round and starts the next one, so the FIFO and error fields trail
+// the hardware by one read; read twice, or loop, for a fresh value. The
+// IRQ bits are live. Between reads the poller stays off the local bus.
+static inline void UserStatus_poll(int on){
+    uint32_t ctrl = CF_REG(USER_CTRL_BASE, CTRL_CONTROL);
+    CF_REG(USER_CTRL_BASE, CTRL_CONTROL) = on ? (ctrl | CTRL_STATUS_POLL) : (ctrl & ~CTRL_STATUS_POLL);
+}
+
+static inline uint32_t UserStatus_snapshot(void){
+    return CF_REG(USER_CTRL_BASE, CTRL_SNAPSHOT);
+}
+
+// Idle clock gating. gate is a mask of CTRL_SPI_CLK_GATE and
+// CTRL_UART_CLK_GATE; idle picks the idle time, 2^(idle+4) cycles. A
+// UART clock also stays on for a frame after each edge, so any idle
+// value is safe. Change idle only with gating off.
+static inline void UserClk_gate(uint32_t gate, uint32_t idle){
+    uint32_t ctrl = CF_REG(USER_CTRL_BASE, CTRL_CONTROL) &
+                    ~(CTRL_SPI_CLK_GATE | CTRL_UART_CLK_GATE | CTRL_CLK_IDLE_MASK);
+    CF_REG(USER_CTRL_BASE, CTRL_CONTROL) = ctrl | CTRL_CLK_IDLE(idle);
+    if (gate)
+        CF_REG(USER_CTRL_BASE, CTRL_CONTROL) = ctrl | CTRL_CLK_IDLE(idle) | gate;
+}
+
+// LA mailbox. Pushes move up to 16 bytes into the SPI or UART TX FIFO
+// per handshake and pops take up to 15 bytes from an RX FIFO, with no
+// Wishbone traffic. While it is on, la_data_out carries the mailbox
+// response instead of the debug mirror. One push and one pop may be
+// outstanding at a time.
+static uint32_t user_lam_req;   // shadow of reg_la0_oenb
+
+static void UserLa_enable(int on){
+    uint32_t ctrl = CF_REG(USER_CTRL_BASE, CTRL_CONTROL) & ~CTRL_LA_MAILBOX;
+    if (on) {
+        // Drive and read back all 128 probes
+        reg_la0_iena = reg_la1_iena = reg_la2_iena = reg_la3_iena = 0;
+        reg_la1_oenb = reg_la2_oenb = reg_la3_oenb = 0xFFFFFFFF;
+        user_lam_req = 0xFFFFFFFF & ~LAM_REQ_MASK;
+        reg_la0_oenb = user_lam_req;
+        ctrl |= CTRL_LA_MAILBOX;
+    }
+    CF_REG(USER_CTRL_BASE, CTRL_CONTROL) = ctrl;
+}
+
+// Queue len (1-16) bytes. Returns once the mailbox has taken the previous
+// push and this one is on its way; the bytes reach the TX FIFO in order.
+static void UserLa_push(int uart, const uint8_t *buf, int len){
+    uint32_t w[4] = {0, 0, 0, 0};
+    for (int i = 0; i < len; i++)
+        w[i >> 2] |= (uint32_t)buf[i] << (8 * (i & 3));
+
+    while (!(reg_la3_data_in & LAM_PUSH_ACK) != !(user_lam_req & LAM_PUSH))
+        ;
+    reg_la0_data = w[0];
+    reg_la1_data = w[1];
+    reg_la2_data = w[2];
+    reg_la3_data = w[3];
+
+    user_lam_req &= ~(LAM_PUSH_UART | LAM_PUSH_LEN(16));
+    user_lam_req ^= LAM_PUSH;
+    user_lam_req |= (uart ? LAM_PUSH_UART : 0) | LAM_PUSH_LEN(len);
+    reg_la0_oenb = user_lam_req;
+}
+
+// Take up to LAM_POP_MAX received bytes. Returns how many were available.
+static int UserLa_pop(int uart, uint8_t *buf){
+    uint32_t w[4];
+    int n;
+
+    user_lam_req &= ~LAM_POP_UART;
+    user_lam_req ^= LAM_POP;
+    user_lam_req |= uart ? LAM_POP_UART : 0;
+    reg_la0_oenb = user_lam_req;
+
+    while (!(reg_la3_data_in & LAM_POP_ACK) != !(user_lam_req & LAM_POP))
+        ;
+    w[0] = reg_la0_data_in;
+    w[1] = reg_la1_data_in;
+    w[2] = reg_la2_data_in;
+    w[3] = reg_la3_data_in;
+
+    n = LAM_POP_COUNT(w[3]);
+    for (int i = 0; i < n; i++)
+        buf[i] = w[i >> 2] >> (8 * (i & 3));
+    return n;
+}
+
+// Framed UART. While the framer is enabled it owns channel 0's FIFOs, so
+// the ring and scatter-gather calls must not be used on that channel.
+static inline void UserFrame_enable(int cobs){
+    CF_REG(USER_FRM_BASE, FRM_CTRL) = FRM_CTRL_EN | (cobs ? FRM_CTRL_COBS : 0);
+}
+
+// Queue one whole frame for encoding. Returns the bytes queued. Waiting
+// on TX_FULL keeps TX_OVERFLOW clear; a byte written while full is lost.
+static int UserFrame_send(const uint8_t *buf, int len){
+    int n;
+    for (n = 0; n < len; n++) {
+        while (CF_REG(USER_FRM_BASE, FRM_STATUS) & FRM_STATUS_TX_FULL)
+            ;
+        CF_REG(USER_FRM_BASE, FRM_TXDATA) = buf[n] | (n == len - 1 ? FRM_TX_END : 0);
+    }
+    return n;
+}
+
+// Take the next complete frame. Returns its length, -1 if it was
+// corrupted (its bytes are dropped) or 0 if none is waiting. Bytes past
+// max are dropped. Only for frames that fit the 32-byte RX FIFO; longer
+// ones have to be read from FRM_RXDATA while they arrive.
+static int UserFrame_recv(uint8_t *buf, int max){
+    uint32_t info = CF_REG(USER_FRM_BASE, FRM_RXLEN);
+    int len = info & 0xFFFF;
+    if (!(info & FRM_RXLEN_VALID))
+        return 0;
+    for (int n = 0; n < len; n++) {
+        uint8_t b = CF_REG(USER_FRM_BASE, FRM_RXDATA);
+        if (n < max)
+            buf[n] = b;
+    }
+    return (info & FRM_RXLEN_ERROR) ? -1 : len;
+}
+
+static inline int UserUart_write(const uint8_t *buf, int len){ return UserSerial_write(&user_uart_dev, buf, len); }
+static inline int UserUart_read(uint8_t *buf, int len){ return UserSerial_read(&user_uart_dev, buf, len); }
+static inline int UserUart_flush(void){ return UserSerial_flush(&user_uart_dev); }
+
+// SPI API. The SPI master receives one byte per byte sent, so read()
+// returns the replies to earlier write() calls.
+static void UserSpi_init(uint32_t prescaler, uint32_t cfg){
+    CF_REG(USER_SPI_BASE, SPI_CTRL) = 0;
+    CF_REG(USER_SPI_BASE, SPI_CFG) = cfg;
+    CF_REG(USER_SPI_BASE, SPI_PR) = prescaler;
+    UserSerial_start(&user_spi_dev);
+    CF_REG(USER_SPI_BASE, SPI_CTRL) = SPI_CTRL_EN | SPI_CTRL_RXEN;
+}
+
+static inline void UserSpi_select(int on){
+    uint32_t ctrl = CF_REG(USER_SPI_BASE, SPI_CTRL);
+    CF_REG(USER_SPI_BASE, SPI_CTRL) = on ? (ctrl | SPI_CTRL_SS) : (ctrl & ~SPI_CTRL_SS);
+}
+
+static inline int UserSpi_write(const uint8_t *buf, int len){ return UserSerial_write(&user_spi_dev, buf, len); }
+static inline int UserSpi_read(uint8_t *buf, int len){ return UserSerial_read(&user_spi_dev, buf, len); }
+static inline int UserSpi_flush(void){ return UserSerial_flush(&user_spi_dev); }
+
+// Scatter-gather transfers
+typedef struct {
+    void *base;
+    uint32_t len;
+} UserIovec;
+
+// Walks an iovec list one byte at a time without copying it anywhere
+typedef struct {
+    const UserIovec *iov;
+    int cnt;
+    uint32_t off;
+} UserIovCursor;
+
+static inline void UserIov_begin(UserIovCursor *c, const UserIovec *iov, int cnt){
+    c->iov = iov;
+    c->cnt = cnt;
+    c->off = 0;
+    while (c->cnt && c->iov->len == 0) {
+        c->iov++;
+        c->cnt--;
+    }
+}
+
+static inline int UserIov_done(UserIovCursor *c){
+    return c->cnt == 0;
+}
+
+static inline uint8_t *UserIov_next(UserIovCursor *c){
+    uint8_t *p = (uint8_t*)c->iov->base + c->off;
+    if (++c->off == c->iov->len) {
+        c->off = 0;
+        do {
+            c->iov++;
+            c->cnt--;
+        } while (c->cnt && c->iov->len == 0);
+    }
+    return p;
+}
+
+static inline uint32_t UserIov_total(const UserIovec *iov, int cnt){
+    uint32_t n = 0;
+    while (cnt--)
+        n += (iov++)->len;
+    return n;
+}
+
+// Stream every buffer into the TX FIFO. Returns the bytes sent.
+static uint32_t UserSerial_writev(UserSerialDev *d, const UserIovec *iov, int cnt){
+    UserIovCursor c;
+    uint32_t sent = 0;
+
+    UserIov_begin(&c, iov, cnt);
+    while (!UserIov_done(&c)) {
+        uint32_t room = SPI_UART_FIFO_ROOM - CF_REG(d->base, CF_TX_FIFO_LEVEL);
+        while (room-- && !UserIov_done(&c)) {
+            CF_REG(d->base, CF_TXDATA) = *UserIov_next(&c);
+            sent++;
+        }
+    }
+    return sent;
+}
+
+// Fill every buffer from the RX FIFO. Returns the bytes received.
+static uint32_t UserSerial_readv(UserSerialDev *d, const UserIovec *iov, int cnt){
+    UserIovCursor c;
+    uint32_t got = 0;
+
+    UserIov_begin(&c, iov, cnt);
+    while (!UserIov_done(&c)) {
+        uint32_t level = CF_REG(d->base, CF_RX_FIFO_LEVEL);
+        while (level-- && !UserIov_done(&c)) {
+            *UserIov_next(&c) = CF_REG(d->base, CF_RXDATA);
+            got++;
+        }
+    }
+    return got;
+}
+
+static inline uint32_t UserUart_writev(const UserIovec *iov, int cnt){ return UserSerial_writev(&user_uart_dev, iov, cnt); }
+static inline uint32_t UserUart_readv(const UserIovec *iov, int cnt){ return UserSerial_readv(&user_uart_dev, iov, cnt); }
+
+// Full-duplex SPI transfer. Every byte sent clocks one byte in, so at
+// most a FIFO's worth is kept in flight: neither FIFO can overflow and
+// only the RX level is read. Received bytes beyond the rx list (or all
+// of them when rx is NULL) are discarded.
+static uint32_t UserSpi_xferv(const UserIovec *tx, int txcnt, const UserIovec *rx, int rxcnt){
+    UserIovCursor tc, rc;
+    uint32_t total = UserIov_total(tx, txcnt);
+    uint32_t sent = 0;
+    uint32_t got = 0;
+
+    UserIov_begin(&tc, tx, txcnt);
+    UserIov_begin(&rc, rx, rx ? rxcnt : 0);
+    while (got < total) {
+        uint32_t burst = SPI_UART_FIFO_ROOM - (sent - got);
+        while (burst-- && !UserIov_done(&tc)) {
+            CF_REG(USER_SPI_BASE, CF_TXDATA) = *UserIov_next(&tc);
+            sent++;
+        }
+
+        uint32_t level = CF_REG(USER_SPI_BASE, CF_RX_FIFO_LEVEL);
+        while (level--) {
+            uint8_t b = CF_REG(USER_SPI_BASE, CF_RXDATA);
+            if (!UserIov_done(&rc))
+                *UserIov_next(&rc) = b;
+            got++;
+        }
+    }
+    return got;
+}
+
+// Interrupt service for both windows
+static void UserSpiUart_isr(void){
+    UserSerial_service(&user_spi_dev);
+    UserSerial_service(&user_uart_dev);
+}
+
+#endif // SPI_UART_DRV_H
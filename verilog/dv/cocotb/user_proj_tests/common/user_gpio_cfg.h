@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+// One-shot GPIO configuration for user_proj_example.
+//
+// The table mirrors the GPIO assignment in verilog/rtl/user_proj_example.v
+// (default N_UART = 2). Every pin register is written exactly once and the
+// serial chain is loaded once. UserProject_waitReady() then returns as
+// soon as the user project answers on Wishbone instead of spinning for a
+// fixed time.
+
+#ifndef USER_GPIO_CFG_H
+#define USER_GPIO_CFG_H
+
+#include <stdint.h>
+
+#define USER_GPIO_COUNT         38
+
+#define USER_PROJECT_VERSION    0x01000000
+#define reg_user_version        (*(volatile uint32_t*)(0x30000000 + 0xF008))
+
+static const enum gpio_mode user_gpio_modes[USER_GPIO_COUNT] = {
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 0-4: not used by the user project
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 5: SPI MOSI / QSPI IO0 (input in slave mode)
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 6: SPI MISO / QSPI IO1
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 7: SPI SCLK (input in slave mode)
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 8: SPI CSB (input in slave mode)
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 9: UART TX
+    GPIO_MODE_USER_STD_INPUT_NOPULL,    // 10: UART RX
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 11: SPI activity LED
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 12: UART activity LED
+    GPIO_MODE_USER_STD_INPUT_NOPULL,    // 13: SPI enable
+    GPIO_MODE_USER_STD_INPUT_NOPULL,    // 14: UART enable
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 15: QSPI IO2
+    GPIO_MODE_USER_STD_BIDIRECTIONAL,   // 16: QSPI IO3
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 17: UART1 TX
+    GPIO_MODE_USER_STD_INPUT_NOPULL,    // 18: UART1 RX
+    GPIO_MODE_USER_STD_OUT_MONITORED,   // 19-37: unused, monitored
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+    GPIO_MODE_USER_STD_OUT_MONITORED,
+};
+
+// Write the table and load it into the pads in one serial transfer.
+// GPIOs_loadConfigs() returns once the transfer engine reports idle.
+static void UserGpio_configure(void){
+    for (int i = 0; i < USER_GPIO_COUNT; i++)
+        GPIOs_configure(i, user_gpio_modes[i]);
+    GPIOs_loadConfigs();
+}
+
+// Wait until the user project is out of reset and answering on Wishbone
+static void UserProject_waitReady(void){
+    User_enableIF(1);
+    while (reg_user_version != USER_PROJECT_VERSION);
+}
+
+#endif // USER_GPIO_CFG_H
@@ -0,0 +1,174 @@
+# SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#      http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# SPDX-License-Identifier: Apache-2.0
+
+"""Wishbone master for the user project slave port (wbs_*).
+
+Every access completes on wbs_ack_o, not after a fixed delay, and
+fails with WishboneTimeout if no ack arrives. The driver forces the
+wbs_* inputs of the given instance while it owns the bus, so the
+firmware must stay off the user project bus until release() is called.
+
+Access styles:
+- read / write: single cycle, CYC and STB dropped after the ack
+- burst_read / burst_write: CYC held for the whole block, one beat
+  per ack
+- pipelined_read / pipelined_write: B4 pipelined, a new request
+  every cycle the slave does not stall. Without a stall signal (the
+  Caravel user port has none) only one request is kept in flight
+  and the next one is presented in the same cycle as the ack.
+
+Per-access latency (cycles from strobe to ack) is kept in `latency`.
+"""
+
+from cocotb.handle import Force, Release
+from cocotb.triggers import RisingEdge
+
+USER_WB_BASE = 0x30000000
+
+
+class WishboneTimeout(Exception):
+    pass
+
+
+class WishboneMaster:
+    def __init__(self, clk, bus, base=USER_WB_BASE, timeout=1000, stall=None):
+        self.clk = clk
+        self.bus = bus
+        self.base = base
+        self.timeout = timeout
+        self.stall = stall
+        self.latency = []
+        self._owned = False
+
+    # ---- Single accesses ----
+
+    async def read(self, addr):
+        return (await self._block([(False, addr, 0)]))[0]
+
+    async def write(self, addr, data, sel=0xF):
+        await self._block([(True, addr, data)], sel)
+
+    # ---- Classic block cycles ----
+
+    async def burst_read(self, addr, count, stride=4):
+        return await self._block([(False, addr + i * stride, 0) for i in range(count)])
+
+    async def burst_write(self, addr, data, stride=4, sel=0xF):
+        await self._block([(True, addr + i * stride, d) for i, d in enumerate(data)], sel)
+
+    # ---- Pipelined ----
+
+    async def pipelined_read(self, addrs):
+        return await self._pipelined([(False, a, 0) for a in addrs])
+
+    async def pipelined_write(self, addrs, data, sel=0xF):
+        return await self._pipelined([(True, a, d) for a, d in zip(addrs, data)], sel)
+
+    def release(self):
+        """Hand the bus back to the management core."""
+        if self._owned:
+            for sig in self._inputs():
+                sig.value = Release()
+            self._owned = False
+
+    def stats(self):
+        """(count, min, max, mean) access latency in cycles"""
+        if not self.latency:
+            return (0, 0, 0, 0.0)
+        return (len(self.latency), min(self.latency), max(self.latency),
+                sum(self.latency) / len(self.latency))
+
+    # ---- Internals ----
+
+    def _inputs(self):
+        b = self.bus
+        return (b.wbs_cyc_i, b.wbs_stb_i, b.wbs_we_i, b.wbs_sel_i, b.wbs_adr_i, b.wbs_dat_i)
+
+    def _drive(self, cyc, stb, we=0, sel=0, addr=0, data=0):
+        b = self.bus
+        b.wbs_cyc_i.value = Force(cyc)
+        b.wbs_stb_i.value = Force(stb)
+        b.wbs_we_i.value = Force(we)
+        b.wbs_sel_i.value = Force(sel)
+        b.wbs_adr_i.value = Force((self.base | addr) & 0xFFFFFFFF)
+        b.wbs_dat_i.value = Force(data & 0xFFFFFFFF)
+        self._owned = True
+
+    @staticmethod
+    def _high(sig):
+        v = sig.value
+        return v.is_resolvable and v.integer == 1
+
+    def _rdata(self):
+        v = self.bus.wbs_dat_o.value
+        return v.integer if v.is_resolvable else 0
+
+    async def _block(self, ops, sel=0xF):
+        """Classic cycle(s): one op per ack with CYC held throughout.
+
+        Signals read right after a rising edge hold their pre-edge value,
+        which is what a synchronous master samples at that edge.
+        """
+        result = []
+        for we, addr, data in ops:
+            self._drive(1, 1, int(we), sel, addr, data)
+            cycles = 0
+            while True:
+                await RisingEdge(self.clk)
+                cycles += 1
+                if self._high(self.bus.wbs_ack_o):
+                    break
+                if cycles >= self.timeout:
+                    self._drive(0, 0)
+                    raise WishboneTimeout(
+                        f"no ack for {'write' if we else 'read'} at {addr:#06x} after {cycles} cycles")
+            self.latency.append(cycles)
+            result.append(None if we else self._rdata())
+        self._drive(0, 0)
+        await RisingEdge(self.clk)  # idle cycle between bus cycles
+        return result
+
+    async def _pipelined(self, ops, sel=0xF):
+        if self.stall is None:
+            # Back-to-back classic: the next request goes out with the ack
+            return await self._block(ops, sel)
+
+        issued = []     # issue cycle of each request still waiting for ack
+        result = []
+        cycle = 0
+        idx = 0
+        while idx < len(ops) or issued:
+            if idx < len(ops):
+                we, addr, data = ops[idx]
+                self._drive(1, 1, int(we), sel, addr, data)
+            else:
+                self._drive(1, 0)
+            await RisingEdge(self.clk)
+            cycle += 1
+            # Acks seen at this edge belong to earlier requests
+            if self._high(self.bus.wbs_ack_o) and issued:
+                start, we = issued.pop(0)
+                self.latency.append(cycle - start + 1)
+                result.append(None if we else self._rdata())
+            if idx < len(ops) and not self._high(self.stall):
+                issued.append((cycle, ops[idx][0]))
+                idx += 1
+            if issued and cycle - issued[0][0] >= self.timeout:
+                self._drive(0, 0)
+                raise WishboneTimeout(f"pipelined access timed out after {cycle} cycles")
+        self._drive(0, 0)
+        await RisingEdge(self.clk)
+        return result
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+// Benchmark run markers shared by the spi_uart_bench firmware.
+//
+// Every measured run is bracketed by the management GPIO: the run id goes
+// to debug_reg2, then the GPIO is raised for exactly the measured section
+// and dropped again. A final window with run id 0 ends the benchmark;
+// debug_reg1 holds the pass code by then.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../common/selfcheck.h"
+
+#define BENCH_END   0
+
+static inline void Bench_begin(uint32_t run){
+    set_debug_reg2(run);
+    ManagmentGpio_write(1);
+}
+
+static inline void Bench_end(void){
+    ManagmentGpio_write(0);
+}
+
+static void Bench_finish(int errors){
+    UserTest_report(errors);
+    Bench_begin(BENCH_END);
+    Bench_end();
+}
+
+#endif // BENCH_H
@@ -0,0 +1,198 @@
+# SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#      http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# SPDX-License-Identifier: Apache-2.0
+
+# Throughput and latency benchmarks. Every test appends its results to
+# bench_<test>.csv in the simulation directory, one row per measurement:
+#
+#   bench,param,metric,value,unit
+#
+# The firmware marks each measured run with the management GPIO and puts
+# the run id in debug_reg2 (see bench.h).
+
+import csv
+import os
+
+from caravel_cocotb.caravel_interfaces import test_configure
+from caravel_cocotb.caravel_interfaces import report_test
+import cocotb
+from cocotb.triggers import RisingEdge
+from cocotb.utils import get_sim_time
+from user_proj_tests.common.wb_bfm import WishboneMaster
+from user_proj_tests.common.selfcheck import check_pass_code
+
+BENCH_END = 0
+SPI_BENCH_BYTES = 64
+UART_BENCH_BYTES = 32
+
+
+class BenchCsv:
+    def __init__(self, name):
+        self.name = name
+        self.path = os.path.abspath(f"bench_{name}.csv")
+        self.rows = []
+
+    def add(self, param, metric, value, unit):
+        self.rows.append((self.name, param, metric, value, unit))
+        cocotb.log.info(f"[BENCH] {self.name} {param} {metric} = {value} {unit}")
+
+    def write(self):
+        with open(self.path, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(("bench", "param", "metric", "value", "unit"))
+            w.writerows(self.rows)
+        cocotb.log.info(f"[BENCH] Results written to {self.path}")
+
+
+async def clock_period_ns(clk):
+    await RisingEdge(clk)
+    t0 = get_sim_time(units="ns")
+    await RisingEdge(clk)
+    return get_sim_time(units="ns") - t0
+
+
+async def bench_windows(caravelEnv):
+    """Collect (run id, duration in ns) for every marked run up to the end marker"""
+    runs = []
+    while True:
+        await caravelEnv.wait_mgmt_gpio(1)
+        t0 = get_sim_time(units="ns")
+        run = caravelEnv.read_debug_reg2()
+        await caravelEnv.wait_mgmt_gpio(0)
+        if run == BENCH_END:
+            return runs
+        runs.append((run, get_sim_time(units="ns") - t0))
+
+
+async def throughput_bench(dut, name, nbytes, divider_of):
+    caravelEnv = await test_configure(dut, timeout_cycles=50000000)
+    cocotb.log.info(f"[TEST] Start {name} test")
+    await caravelEnv.release_csb()
+
+    period = await clock_period_ns(caravelEnv.clk)
+    out = BenchCsv(name)
+    for run, dt in await bench_windows(caravelEnv):
+        divider = divider_of(run)
+        out.add(divider, "time", f"{dt:.0f}", "ns")
+        out.add(divider, "cycles", f"{dt / period:.0f}", "cycles")
+        out.add(divider, "throughput", f"{nbytes / (dt * 1e-9):.0f}", "bytes/s")
+    out.write()
+
+    check_pass_code(caravelEnv, "Benchmark data check")
+
+
+@cocotb.test()
+@report_test
+async def spi_uart_bench_spi(dut):
+    """Sustained SPI throughput at each prescaler"""
+    await throughput_bench(dut, "spi_uart_bench_spi", SPI_BENCH_BYTES, lambda run: run)
+
+
+@cocotb.test()
+@report_test
+async def spi_uart_bench_uart(dut):
+    """Sustained UART throughput at each prescaler"""
+    await throughput_bench(dut, "spi_uart_bench_uart", UART_BENCH_BYTES, lambda run: run - 1)
+
+
+@cocotb.test()
+@report_test
+async def spi_uart_bench_wb_latency(dut):
+    """Wishbone access latency per address region"""
+    caravelEnv = await test_configure(dut, timeout_cycles=10000000)
+    cocotb.log.info(f"[TEST] Start spi_uart_bench_wb_latency test")
+    await caravelEnv.release_csb()
+    await bench_windows(caravelEnv)
+
+    period = await clock_period_ns(caravelEnv.clk)
+    out = BenchCsv("spi_uart_bench_wb_latency")
+    regions = [
+        ("ctrl", 0xF008),   # VERSION, bus clock
+        ("dma_buf", 0x2000),
+        ("spi", 0x0010),    # SPI PR, through the ser_clk bridge
+        ("uart", 0x1008),   # UART PR
+        ("qspi", 0x3010),   # QSPI PR, through its bridge
+    ]
+    for region, addr in regions:
+        for kind in ("read", "write", "burst_read"):
+            wb = WishboneMaster(caravelEnv.clk, caravelEnv.caravel_hdl.mprj)
+            for _ in range(8):
+                if kind == "read":
+                    await wb.read(addr)
+                elif kind == "write":
+                    await wb.write(addr, 0x4 if region != "ctrl" else 0)
+                else:
+                    await wb.burst_read(addr, 4, stride=0)
+            count, lat_min, lat_max, lat_avg = wb.stats()
+            wb.release()
+            param = f"{region}_{kind}"
+            out.add(param, "min", lat_min, "cycles")
+            out.add(param, "max", lat_max, "cycles")
+            out.add(param, "mean", f"{lat_avg:.2f}", "cycles")
+            out.add(param, "mean_ns", f"{lat_avg * period:.1f}", "ns")
+    out.write()
+
+
+@cocotb.test()
+@report_test
+async def spi_uart_bench_irq_latency(dut):
+    """irq[1] assertion to RXDATA service latency"""
+    caravelEnv = await test_configure(dut, timeout_cycles=20000000)
+    cocotb.log.info(f"[TEST] Start spi_uart_bench_irq_latency test")
+    await caravelEnv.release_csb()
+
+    mprj = caravelEnv.caravel_hdl.mprj
+    samples = []
+
+    def high(sig):
+        v = sig.value
+        return v.is_resolvable and v.integer == 1
+
+    async def watch():
+        cycles = None
+        irq_q = False
+        while True:
+            await RisingEdge(caravelEnv.clk)
+            irq = high(mprj.irq[1])
+            if irq and not irq_q:
+                cycles = 0
+            elif cycles is not None:
+                cycles += 1
+            irq_q = irq
+            # RXDATA read completed on the user port
+            if (cycles is not None and high(mprj.wbs_ack_o) and high(mprj.wbs_stb_i)
+                    and not high(mprj.wbs_we_i)
+                    and mprj.wbs_adr_i.value.is_resolvable
+                    and mprj.wbs_adr_i.value.integer == 0x30001000):
+                samples.append(cycles)
+                cycles = None
+
+    period = await clock_period_ns(caravelEnv.clk)
+    watcher = cocotb.start_soon(watch())
+    await bench_windows(caravelEnv)
+    watcher.kill()
+
+    out = BenchCsv("spi_uart_bench_irq_latency")
+    if samples:
+        out.add("uart_rxa", "samples", len(samples), "count")
+        out.add("uart_rxa", "min", min(samples), "cycles")
+        out.add("uart_rxa", "max", max(samples), "cycles")
+        out.add("uart_rxa", "mean", f"{sum(samples) / len(samples):.2f}", "cycles")
+        out.add("uart_rxa", "mean_ns", f"{sum(samples) / len(samples) * period:.1f}", "ns")
+    else:
+        cocotb.log.error(f"[TEST] No IRQ service was observed")
+    out.write()
+
+    check_pass_code(caravelEnv, "IRQ latency run")
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/spi_uart_drv.h"
+#include "bench.h"
+
+// IRQ-assert-to-service latency. One byte at a time is looped back
+// through the UART; the RX interrupt raises irq[1] and the firmware
+// services it by reading RXDATA. The testbench times each irq[1] rising
+// edge to the next RXDATA read on the bus. The handler is polled from
+// UART_IRQ (0xF00C), as in spi_uart_interrupts.
+
+#define reg_uart_irq_status (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF00C))
+
+#define BENCH_SAMPLES   16
+#define BENCH_TIMEOUT   100000
+
+void main(){
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+    UserGpio_configure(); // one-shot pin table load
+    UserProject_waitReady();
+
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = UART_IRQ_RXA;
+
+    Bench_begin(1);
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        int t;
+
+        CF_REG(USER_UART_BASE, CF_TXDATA) = i;
+        for (t = 0; t < BENCH_TIMEOUT; t++)
+            if (reg_uart_irq_status & 0x1)
+                break;
+        if (t == BENCH_TIMEOUT) {
+            errors++;
+            break;
+        }
+
+        if ((CF_REG(USER_UART_BASE, CF_RXDATA) & 0xFF) != i)
+            errors++;
+        CF_REG(USER_UART_BASE, CF_IC) = UART_IRQ_RXA;
+    }
+    Bench_end();
+
+    Bench_finish(errors);
+    return;
+}
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/spi_uart_drv.h"
+#include "bench.h"
+
+// Sustained SPI master throughput at each prescaler. The bytes go out
+// through UserSpi_xferv, so every run includes the driver cost of
+// keeping both FIFOs fed and drained.
+
+#define BENCH_BYTES 64
+
+static const uint32_t spi_dividers[] = {2, 4, 8, 16, 32, 64, 128, 255};
+
+void main(){
+    static uint8_t tx[BENCH_BYTES];
+    static uint8_t rx[BENCH_BYTES];
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+    UserGpio_configure(); // one-shot pin table load
+    UserProject_waitReady();
+
+    for (int i = 0; i < BENCH_BYTES; i++)
+        tx[i] = i * 37;
+
+    const UserIovec txv[1] = {{tx, BENCH_BYTES}};
+    const UserIovec rxv[1] = {{rx, BENCH_BYTES}};
+
+    for (unsigned d = 0; d < sizeof(spi_dividers) / sizeof(spi_dividers[0]); d++) {
+        UserSpi_init(spi_dividers[d], 0);
+        CF_REG(USER_SPI_BASE, CF_IM) = 0;   // polled
+        UserSpi_select(1);
+
+        Bench_begin(spi_dividers[d]);
+        if (UserSpi_xferv(txv, 1, rxv, 1) != BENCH_BYTES)
+            errors++;
+        Bench_end();
+
+        UserSpi_select(0);
+    }
+
+    Bench_finish(errors);
+    return;
+}
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/spi_uart_drv.h"
+#include "bench.h"
+
+// Sustained UART throughput at each prescaler, in internal loopback.
+// Sending and receiving are interleaved with at most a FIFO's worth in
+// flight, so the line is kept busy and the RX FIFO cannot overrun.
+
+#define BENCH_BYTES 32
+
+static const uint32_t uart_dividers[] = {0, 1, 3, 7, 15, 31, 63};
+
+static int bench_uart_loop(const uint8_t *tx, uint8_t *rx, int len){
+    int sent = 0;
+    int got = 0;
+
+    while (got < len) {
+        int room = SPI_UART_FIFO_ROOM - (sent - got);
+        while (room-- > 0 && sent < len)
+            CF_REG(USER_UART_BASE, CF_TXDATA) = tx[sent++];
+
+        uint32_t level = CF_REG(USER_UART_BASE, CF_RX_FIFO_LEVEL);
+        while (level--)
+            rx[got++] = CF_REG(USER_UART_BASE, CF_RXDATA);
+    }
+    return got;
+}
+
+void main(){
+    static uint8_t tx[BENCH_BYTES];
+    static uint8_t rx[BENCH_BYTES];
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+    UserGpio_configure(); // one-shot pin table load
+    UserProject_waitReady();
+
+    for (int i = 0; i < BENCH_BYTES; i++)
+        tx[i] = 0xA0 ^ i;
+
+    for (unsigned d = 0; d < sizeof(uart_dividers) / sizeof(uart_dividers[0]); d++) {
+        UserUart_init(uart_dividers[d], 1);
+        CF_REG(USER_UART_BASE, CF_IM) = 0;  // polled
+
+        // Run ids are offset by one so divider 0 is not the end marker
+        Bench_begin(uart_dividers[d] + 1);
+        if (bench_uart_loop(tx, rx, BENCH_BYTES) != BENCH_BYTES)
+            errors++;
+        Bench_end();
+
+        for (int i = 0; i < BENCH_BYTES; i++)
+            if (rx[i] != tx[i])
+                errors++;
+    }
+
+    Bench_finish(errors);
+    return;
+}
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "bench.h"
+
+// Wishbone access latency is measured from the testbench with the
+// WishboneMaster driver; the firmware only sets the project up and
+// keeps off the bus while the measurement window is open.
+
+void main(){
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+    UserGpio_configure(); // one-shot pin table load
+    UserProject_waitReady();
+
+    Bench_finish(0);
+    return;
+}
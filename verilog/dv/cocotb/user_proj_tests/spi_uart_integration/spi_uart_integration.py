@@ -20,6 +20,7 @@ from caravel_cocotb.caravel_interfaces import UART
 from caravel_cocotb.caravel_interfaces import SPI
 import cocotb
 import random
+from user_proj_tests.common.selfcheck import check_pass_code
 
 @cocotb.test()
 @report_test
@@ -159,6 +160,8 @@ async def spi_uart_interrupts(dut):
             # Handle unresolved values
             pass
     
+    check_pass_code(caravelEnv, "Interrupt-driven UART loopback")
+
     cocotb.log.info(f"[TEST] Interrupt monitoring completed")
 
 @cocotb.test()
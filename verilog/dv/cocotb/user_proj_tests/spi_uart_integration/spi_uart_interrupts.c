@@ -15,33 +15,53 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+#define reg_uart_irq_status (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF00C))
+
+#define IRQ_TEST_BYTES      8
+#define IRQ_TEST_TIMEOUT    100000
 
 void main(){
+    static const uint8_t msg[IRQ_TEST_BYTES] = {'S', 'P', 'I', '/', 'U', 'A', 'R', 'T'};
+    uint8_t rx[IRQ_TEST_BYTES];
+    int received = 0;
+    int errors = 0;
+
     // Enable management gpio as output to use as indicator for finishing configuration  
     ManagmentGpio_outputEnable();
     ManagmentGpio_write(0);
     enableHkSpi(0); // disable housekeeping spi
-    
-    // Configure GPIOs for SPI/UART interrupt test
-    GPIOs_configureAll(GPIO_MODE_USER_STD_OUT_MONITORED);
-    GPIOs_configure(5, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_MOSI
-    GPIOs_configure(6, GPIO_MODE_USER_STD_INPUT_NOPULL);       // SPI_MISO
-    GPIOs_configure(7, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_SCLK
-    GPIOs_configure(8, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_CSB
-    GPIOs_configure(9, GPIO_MODE_USER_STD_OUT_MONITORED);      // UART_TX
-    GPIOs_configure(10, GPIO_MODE_USER_STD_INPUT_NOPULL);      // UART_RX
-    GPIOs_configure(11, GPIO_MODE_USER_STD_OUT_MONITORED);     // SPI_LED
-    GPIOs_configure(12, GPIO_MODE_USER_STD_OUT_MONITORED);     // UART_LED
-    GPIOs_configure(13, GPIO_MODE_USER_STD_INPUT_NOPULL);      // SPI_EN
-    GPIOs_configure(14, GPIO_MODE_USER_STD_INPUT_NOPULL);      // UART_EN
-    
-    GPIOs_loadConfigs(); // load the configuration 
+    User_enableIF(1); // enable the user project Wishbone interface
+
+    UserGpio_configure(); // one-shot pin table load
     ManagmentGpio_write(1); // configuration finished 
     
-    // Enable SPI and UART
-    // Note: We can't directly write to input GPIOs, so we'll just monitor them
-    
-    ManagmentGpio_write(0); // test configuration finished 
+    // Send a message through the UART in internal loopback with the
+    // interrupt-driven driver. The handler runs whenever UART_IRQ shows
+    // channel 0 pending, as it would from the irq[1] vector.
+    UserUart_init(1, 1);
+
+    int queued = UserUart_write(msg, IRQ_TEST_BYTES);
+    if (queued != IRQ_TEST_BYTES)
+        errors++;
+
+    for (int t = 0; t < IRQ_TEST_TIMEOUT && received < IRQ_TEST_BYTES; t++) {
+        if (reg_uart_irq_status & 0x1)
+            UserSpiUart_isr();
+        received += UserUart_read(rx + received, IRQ_TEST_BYTES - received);
+    }
+
+    if (received != IRQ_TEST_BYTES || UserUart_flush() != 0)
+        errors++;
+    for (int i = 0; i < received; i++) {
+        if (rx[i] != msg[i])
+            errors++;
+    }
+
+    UserTest_finish(errors);
     
     return;
 } 
\ No newline at end of file
@@ -15,27 +15,15 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
 
 void main(){
     // Enable management gpio as output to use as indicator for finishing configuration  
     ManagmentGpio_outputEnable();
     ManagmentGpio_write(0);
     enableHkSpi(0); // disable housekeeping spi
-    
-    // Configure GPIOs for SPI/UART logic analyzer test
-    GPIOs_configureAll(GPIO_MODE_USER_STD_OUT_MONITORED);
-    GPIOs_configure(5, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_MOSI
-    GPIOs_configure(6, GPIO_MODE_USER_STD_INPUT_NOPULL);       // SPI_MISO
-    GPIOs_configure(7, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_SCLK
-    GPIOs_configure(8, GPIO_MODE_USER_STD_OUT_MONITORED);      // SPI_CSB
-    GPIOs_configure(9, GPIO_MODE_USER_STD_OUT_MONITORED);      // UART_TX
-    GPIOs_configure(10, GPIO_MODE_USER_STD_INPUT_NOPULL);      // UART_RX
-    GPIOs_configure(11, GPIO_MODE_USER_STD_OUT_MONITORED);     // SPI_LED
-    GPIOs_configure(12, GPIO_MODE_USER_STD_OUT_MONITORED);     // UART_LED
-    GPIOs_configure(13, GPIO_MODE_USER_STD_INPUT_NOPULL);      // SPI_EN
-    GPIOs_configure(14, GPIO_MODE_USER_STD_INPUT_NOPULL);      // UART_EN
-    
-    GPIOs_loadConfigs(); // load the configuration 
+
+    UserGpio_configure(); // one-shot pin table load
     ManagmentGpio_write(1); // configuration finished 
     
     // Enable SPI and UART for logic analyzer monitoring
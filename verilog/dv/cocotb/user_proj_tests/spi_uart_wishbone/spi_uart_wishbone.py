@@ -17,6 +17,8 @@
 from caravel_cocotb.caravel_interfaces import test_configure
 from caravel_cocotb.caravel_interfaces import report_test
 import cocotb
+from user_proj_tests.common.wb_bfm import WishboneMaster
+from user_proj_tests.common.selfcheck import run_selfcheck
 
 @cocotb.test()
 @report_test
@@ -63,83 +65,31 @@ async def spi_uart_wishbone_registers(dut):
     await caravelEnv.release_csb()
     await caravelEnv.wait_mgmt_gpio(1)
     await caravelEnv.wait_mgmt_gpio(0)
-    
-    # Test control register access (0xF000-0xFFFF)
-    # These are our custom control registers
-    
-    # Read version register (0xF008) - should return 0x01000000
-    version_reg = 0xF008
-    cocotb.log.info(f"[TEST] Attempting to read version register at {version_reg:08x}")
-    
-    # Simulate Wishbone read transaction
-    caravelEnv.caravel_hdl.mprj.wbs_adr_i.value = version_reg
-    caravelEnv.caravel_hdl.mprj.wbs_cyc_i.value = 1
-    caravelEnv.caravel_hdl.mprj.wbs_stb_i.value = 1
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 0  # Read
-    
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    wb_data_val = caravelEnv.caravel_hdl.mprj.wbs_dat_o.value
-    
-    # Handle 'x' values safely
-    try:
-        wb_data = wb_data_val.integer
-        cocotb.log.info(f"[TEST] Version register read - ACK: {wb_ack}, DATA: {wb_data:08x}")
-    except ValueError:
-        wb_data_str = str(wb_data_val)
-        cocotb.log.info(f"[TEST] Version register read - ACK: {wb_ack}, DATA: {wb_data_str} (unresolved)")
-    
-    # Read status register (0xF000)
-    status_reg = 0xF000
-    cocotb.log.info(f"[TEST] Attempting to read status register at {status_reg:08x}")
-    
-    caravelEnv.caravel_hdl.mprj.wbs_adr_i.value = status_reg
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    wb_data_val = caravelEnv.caravel_hdl.mprj.wbs_dat_o.value
-    
-    try:
-        wb_data = wb_data_val.integer
-        cocotb.log.info(f"[TEST] Status register read - ACK: {wb_ack}, DATA: {wb_data:08x}")
-    except ValueError:
-        wb_data_str = str(wb_data_val)
-        cocotb.log.info(f"[TEST] Status register read - ACK: {wb_ack}, DATA: {wb_data_str} (unresolved)")
-    
-    # Test write to control register (0xF004)
-    control_reg = 0xF004
-    test_data = 0x12345678
-    cocotb.log.info(f"[TEST] Attempting to write {test_data:08x} to control register at {control_reg:08x}")
-    
-    caravelEnv.caravel_hdl.mprj.wbs_adr_i.value = control_reg
-    caravelEnv.caravel_hdl.mprj.wbs_dat_i.value = test_data
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 1  # Write
-    caravelEnv.caravel_hdl.mprj.wbs_sel_i.value = 0xF  # All bytes
-    
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    cocotb.log.info(f"[TEST] Control register write - ACK: {wb_ack}")
-    
-    # Read back the control register
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 0  # Read
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    wb_data_val = caravelEnv.caravel_hdl.mprj.wbs_dat_o.value
-    
-    try:
-        wb_data = wb_data_val.integer
-        cocotb.log.info(f"[TEST] Control register readback - ACK: {wb_ack}, DATA: {wb_data:08x}")
-    except ValueError:
-        wb_data_str = str(wb_data_val)
-        cocotb.log.info(f"[TEST] Control register readback - ACK: {wb_ack}, DATA: {wb_data_str} (unresolved)")
-    
-    # Deassert Wishbone signals
-    caravelEnv.caravel_hdl.mprj.wbs_cyc_i.value = 0
-    caravelEnv.caravel_hdl.mprj.wbs_stb_i.value = 0
-    
+
+    wb = WishboneMaster(caravelEnv.clk, caravelEnv.caravel_hdl.mprj)
+
+    # Version register (0xF008)
+    version = await wb.read(0xF008)
+    cocotb.log.info(f"[TEST] VERSION = {version:08x}")
+    if version != 0x01000000:
+        cocotb.log.error(f"[TEST] VERSION read {version:08x}, expected 01000000")
+
+    # Status register (0xF000)
+    status = await wb.read(0xF000)
+    cocotb.log.info(f"[TEST] STATUS = {status:08x}")
+
+    # CONTROL (0xF004) write and read back. Only the upper half is used so
+    # no bridge or mode bit is switched on.
+    test_data = 0xA5A50000
+    await wb.write(0xF004, test_data)
+    control = await wb.read(0xF004)
+    if control != test_data:
+        cocotb.log.error(f"[TEST] CONTROL read back {control:08x}, expected {test_data:08x}")
+    await wb.write(0xF004, 0)
+
+    wb.release()
+    count, lat_min, lat_max, lat_avg = wb.stats()
+    cocotb.log.info(f"[TEST] {count} accesses, latency min {lat_min} max {lat_max} mean {lat_avg:.1f} cycles")
     cocotb.log.info(f"[TEST] Wishbone register access test completed")
 
 @cocotb.test()
@@ -154,56 +104,150 @@ async def spi_uart_wishbone_data_transfer(dut):
     await caravelEnv.release_csb()
     await caravelEnv.wait_mgmt_gpio(1)
     await caravelEnv.wait_mgmt_gpio(0)
-    
-    # Test SPI IP access (0x0000-0x0FFF)
-    # Write to SPI control register
-    spi_ctrl_reg = 0x0000
-    spi_ctrl_data = 0x00000001  # Enable SPI
-    cocotb.log.info(f"[TEST] Writing {spi_ctrl_data:08x} to SPI control register at {spi_ctrl_reg:08x}")
-    
-    caravelEnv.caravel_hdl.mprj.wbs_adr_i.value = spi_ctrl_reg
-    caravelEnv.caravel_hdl.mprj.wbs_dat_i.value = spi_ctrl_data
-    caravelEnv.caravel_hdl.mprj.wbs_cyc_i.value = 1
-    caravelEnv.caravel_hdl.mprj.wbs_stb_i.value = 1
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 1  # Write
-    caravelEnv.caravel_hdl.mprj.wbs_sel_i.value = 0xF  # All bytes
-    
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    cocotb.log.info(f"[TEST] SPI control register write - ACK: {wb_ack}")
-    
-    # Test UART IP access (0x1000-0x1FFF)
-    # Write to UART control register
-    uart_ctrl_reg = 0x1000
-    uart_ctrl_data = 0x00000001  # Enable UART
-    cocotb.log.info(f"[TEST] Writing {uart_ctrl_data:08x} to UART control register at {uart_ctrl_reg:08x}")
-    
-    caravelEnv.caravel_hdl.mprj.wbs_adr_i.value = uart_ctrl_reg
-    caravelEnv.caravel_hdl.mprj.wbs_dat_i.value = uart_ctrl_data
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 1  # Write
-    
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    cocotb.log.info(f"[TEST] UART control register write - ACK: {wb_ack}")
-    
-    # Read back SPI status
-    caravelEnv.caravel_hdl.mprj.wbs_we_i.value = 0  # Read
-    await cocotb.triggers.ClockCycles(caravelEnv.clk, 5)
-    
-    wb_ack = caravelEnv.caravel_hdl.mprj.wbs_ack_o.value.integer
-    wb_data_val = caravelEnv.caravel_hdl.mprj.wbs_dat_o.value
-    
-    try:
-        wb_data = wb_data_val.integer
-        cocotb.log.info(f"[TEST] SPI status read - ACK: {wb_ack}, DATA: {wb_data:08x}")
-    except ValueError:
-        wb_data_str = str(wb_data_val)
-        cocotb.log.info(f"[TEST] SPI status read - ACK: {wb_ack}, DATA: {wb_data_str} (unresolved)")
-    
-    # Deassert Wishbone signals
-    caravelEnv.caravel_hdl.mprj.wbs_cyc_i.value = 0
-    caravelEnv.caravel_hdl.mprj.wbs_stb_i.value = 0
-    
-    cocotb.log.info(f"[TEST] Wishbone data transfer test completed") 
\ No newline at end of file
+
+    wb = WishboneMaster(caravelEnv.clk, caravelEnv.caravel_hdl.mprj)
+
+    # SPI (0x0000) and UART (0x1000) prescalers, through the ser_clk bridges
+    await wb.write(0x0010, 0x0004)  # SPI PR
+    await wb.write(0x1008, 0x0003)  # UART PR
+    spi_pr = await wb.read(0x0010)
+    uart_pr = await wb.read(0x1008)
+    if spi_pr != 0x0004:
+        cocotb.log.error(f"[TEST] SPI PR read back {spi_pr:08x}")
+    if uart_pr != 0x0003:
+        cocotb.log.error(f"[TEST] UART PR read back {uart_pr:08x}")
+
+    # DMA buffer (0x2000) block write and back-to-back read
+    pattern = [0x11111111 * i for i in range(16)]
+    await wb.burst_write(0x2000, pattern)
+    readback = await wb.pipelined_read([0x2000 + 4 * i for i in range(16)])
+    if readback != pattern:
+        cocotb.log.error(f"[TEST] DMA buffer mismatch: {[hex(x) for x in readback]}")
+
+    wb.release()
+    count, lat_min, lat_max, lat_avg = wb.stats()
+    cocotb.log.info(f"[TEST] {count} accesses, latency min {lat_min} max {lat_max} mean {lat_avg:.1f} cycles")
+    cocotb.log.info(f"[TEST] Wishbone data transfer test completed")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_dma(dut):
+    """Test a DMA copy between two regions of the DMA buffer"""
+    irq_seen = []
+
+    async def watch_dma_irq(caravelEnv):
+        while True:
+            await cocotb.triggers.RisingEdge(caravelEnv.clk)
+            try:
+                if caravelEnv.caravel_hdl.mprj.irq[2].value.integer == 1:
+                    irq_seen.append(True)
+                    return
+            except ValueError:
+                pass
+
+    await run_selfcheck(dut, "spi_uart_wishbone_dma", "DMA transfer", during=watch_dma_irq)
+    if not irq_seen:
+        cocotb.log.error(f"[TEST] DMA completion interrupt on irq[2] was never raised")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_perf(dut):
+    """Test the performance counters and their snapshot-and-clear control"""
+    await run_selfcheck(dut, "spi_uart_wishbone_perf", "Performance counter")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_trace(dut):
+    """Test an address-triggered capture in the trace buffer"""
+    await run_selfcheck(dut, "spi_uart_wishbone_trace", "Trace buffer")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_iov(dut):
+    """Test scatter-gather UART transfers through the firmware driver"""
+    await run_selfcheck(dut, "spi_uart_wishbone_iov", "Scatter-gather transfer")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_spi_slave(dut):
+    """Drive the SPI slave from an external mode 0 host on the SPI pads"""
+    tx = [0x5A, 0xC3, 0x0F, 0xF0, 0x99]
+    expect = [0xA5, 0x3C, 0x81, 0x7E, 0xFF]  # last one underruns
+    half = 4  # SCLK half period in clock cycles: clk/8, the slave's limit
+    rx = []
+
+    # Mode 0: MOSI set up while SCLK is low, both sides sample on the rise
+    async def host(caravelEnv):
+        caravelEnv.drive_gpio_in((8, 8), 0)
+        await cocotb.triggers.ClockCycles(caravelEnv.clk, 2 * half)
+        for byte in tx:
+            value = 0
+            for bit in range(7, -1, -1):
+                caravelEnv.drive_gpio_in((5, 5), (byte >> bit) & 1)
+                await cocotb.triggers.ClockCycles(caravelEnv.clk, half)
+                caravelEnv.drive_gpio_in((7, 7), 1)
+                value = (value << 1) | caravelEnv.monitor_gpio(6, 6).integer
+                await cocotb.triggers.ClockCycles(caravelEnv.clk, half)
+                caravelEnv.drive_gpio_in((7, 7), 0)
+            rx.append(value)
+        await cocotb.triggers.ClockCycles(caravelEnv.clk, half)
+        caravelEnv.drive_gpio_in((8, 8), 1)
+
+    # Host side idle: SPI_ENABLE high, CSB high, SCLK low
+    await run_selfcheck(dut, "spi_uart_wishbone_spi_slave", "SPI slave",
+                        pins=[(13, 1), (8, 1), (7, 0), (5, 0)], during=host)
+    if rx != expect:
+        cocotb.log.error(f"[TEST] MISO bytes {[hex(b) for b in rx]}, expected {[hex(b) for b in expect]}")
+
+async def uart_send(caravelEnv, pin, byte, bit_cycles):
+    """Send one 8N1 frame on a GPIO, LSB first"""
+    for bit in [0] + [(byte >> i) & 1 for i in range(8)] + [1]:
+        caravelEnv.drive_gpio_in((pin, pin), bit)
+        await cocotb.triggers.ClockCycles(caravelEnv.clk, bit_cycles)
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_autobaud(dut):
+    """Auto-baud on UART channel 0 from a 0x55 sent on io[10]"""
+    bit_cycles = 160  # well away from any integer-prescaler rate
+
+    async def peer(caravelEnv):
+        await uart_send(caravelEnv, 10, 0x55, bit_cycles)
+        while caravelEnv.read_debug_reg2() != 1:
+            await cocotb.triggers.ClockCycles(caravelEnv.clk, 100)
+        await uart_send(caravelEnv, 10, 0xA7, bit_cycles)
+
+    # UART enabled, RX idle
+    await run_selfcheck(dut, "spi_uart_wishbone_autobaud", "Auto-baud",
+                        pins=[(14, 1), (10, 1)], during=peer)
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_crc(dut):
+    """Check the CRC engine against the catalogue check values"""
+    await run_selfcheck(dut, "spi_uart_wishbone_crc", "CRC engine")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_framing(dut):
+    """Loop SLIP and COBS frames through the UART framer"""
+    await run_selfcheck(dut, "spi_uart_wishbone_framing", "Framing")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_snapshot(dut):
+    """Track UART FIFO levels through the status snapshot register"""
+    await run_selfcheck(dut, "spi_uart_wishbone_snapshot", "Status snapshot")
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_clkgate(dut):
+    """Stop the SPI and UART core clocks while idle and wake them on access"""
+    # Hold UART RX idle so it does not keep the gate open
+    await run_selfcheck(dut, "spi_uart_wishbone_clkgate", "Clock gating", pins=[(10, 1)])
+
+@cocotb.test()
+@report_test
+async def spi_uart_wishbone_la_mailbox(dut):
+    """Move a UART loopback stream through the logic analyzer mailbox"""
+    await run_selfcheck(dut, "spi_uart_wishbone_la_mailbox", "LA mailbox")
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+static void drain_rx(void){
+    while (CF_REG(USER_UART_BASE, CF_RX_FIFO_LEVEL))
+        (void)CF_REG(USER_UART_BASE, CF_RXDATA);
+}
+
+void main(){
+    uint32_t status;
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+
+    // UART channel 0 on the pads, polled
+    UserUart_init(0, 0);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    // An abort while waiting for the start bit ends the run cleanly
+    UserUart_autoBaud();
+    if (!(UserUart_autoBaudStatus() & BAUD_STATUS_BUSY))
+        errors++;
+    UserUart_autoBaudAbort();
+    if (UserUart_autoBaudStatus() != 0)
+        errors++;
+
+    UserUart_autoBaud();
+
+    ManagmentGpio_write(1); // configuration finished, host sends 0x55
+
+    do {
+        status = UserUart_autoBaudStatus();
+    } while (status & BAUD_STATUS_BUSY);
+    if ((status & (BAUD_STATUS_DONE | BAUD_STATUS_ERROR)) != BAUD_STATUS_DONE)
+        errors++;
+
+    // Whatever the core made of the timing character is discarded
+    for (int i = 0; i < 16; i++)
+        drain_rx();
+    set_debug_reg2(1); // host sends 0xA7 at the same rate
+
+    while (CF_REG(USER_UART_BASE, CF_RX_FIFO_LEVEL) == 0)
+        ;
+    if ((CF_REG(USER_UART_BASE, CF_RXDATA) & 0xFF) != 0xA7)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+#define CLK_OFF_BOTH    (STATUS_SPI_CLK_OFF | STATUS_UART_CLK_OFF)
+
+// Wait for both core clocks to stop (or both to run); returns 0 if they do
+static int wait_clk_off(int off){
+    for (int t = 0; t < 1000; t++)
+        if ((CF_REG(USER_CTRL_BASE, CTRL_STATUS) & CLK_OFF_BOTH) == (off ? CLK_OFF_BOTH : 0))
+            return 0;
+    return 1;
+}
+
+void main(){
+    int errors = 0;
+    uint8_t tx[8] = {0x00, 0xFF, 0x55, 0xAA, 0x0F, 0xF0, 0x81, 0x7E};
+    uint8_t rx[8];
+    const UserIovec tx_iov[1] = {{tx, 8}};
+    const UserIovec rx_iov[1] = {{rx, 8}};
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback, polled; PR = 1 gives 16-cycle bits, so
+    // the shortest idle time, 2^(0+4) cycles, is a single bit time
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+    UserSpi_init(4, 0);
+    CF_REG(USER_SPI_BASE, CF_IM) = 0;
+
+    if (CF_REG(USER_CTRL_BASE, CTRL_STATUS) & CLK_OFF_BOTH)
+        errors++;
+
+    UserClk_gate(CTRL_SPI_CLK_GATE | CTRL_UART_CLK_GATE, 0);
+    errors += wait_clk_off(1);
+
+    // Register accesses wake the cores with no retry needed
+    if (CF_REG(USER_UART_BASE, UART_PR) != 1)
+        errors++;
+    if (CF_REG(USER_SPI_BASE, SPI_PR) != 4)
+        errors++;
+
+    // A stream through the gated UART arrives intact, and the clock
+    // holds for whole frames: all 8 bytes are in before it stops
+    if (UserUart_writev(tx_iov, 1) != 8)
+        errors++;
+    errors += wait_clk_off(1);
+    if (CF_REG(USER_UART_BASE, CF_RX_FIFO_LEVEL) != 8)
+        errors++;
+    if (UserUart_readv(rx_iov, 1) != 8)
+        errors++;
+    for (int i = 0; i < 8; i++)
+        if (rx[i] != tx[i])
+            errors++;
+
+    errors += wait_clk_off(1);
+
+    // The status poller only runs on SNAPSHOT reads, so with polling on
+    // the clocks still stop between reads
+    UserStatus_poll(1);
+    errors += wait_clk_off(1);
+    int t;
+    for (t = 0; t < 100 && !(UserStatus_snapshot() & SNAP_VALID); t++)
+        ;
+    if (t == 100)
+        errors++;
+    errors += wait_clk_off(1);
+    UserStatus_poll(0);
+
+    // Gating off restarts both clocks
+    UserClk_gate(0, 0);
+    errors += wait_clk_off(0);
+
+    UserTest_finish(errors);
+
+    return;
+}
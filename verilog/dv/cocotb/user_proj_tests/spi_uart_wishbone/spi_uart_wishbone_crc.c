@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+#define CRC_UART_BOTH   (CRC_CTRL_EN(CRC_CH_UART_TX) | CRC_CTRL_EN(CRC_CH_UART_RX))
+#define CRC_UART_RST    (CRC_CTRL_RST(CRC_CH_UART_TX) | CRC_CTRL_RST(CRC_CH_UART_RX))
+
+static const uint8_t check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+// Loop the check string through the UART and compare both running CRCs
+static int crc_run(uint32_t ctrl, uint32_t expect){
+    uint8_t rx[9];
+    const UserIovec tx_iov[1] = {{(void*)check, 9}};
+    const UserIovec rx_iov[1] = {{rx, 9}};
+    int errors = 0;
+
+    CF_REG(USER_CRC_BASE, CRC_CTRL) = ctrl | CRC_UART_BOTH | CRC_UART_RST;
+
+    if (UserUart_writev(tx_iov, 1) != 9)
+        errors++;
+    if (UserUart_readv(rx_iov, 1) != 9)
+        errors++;
+
+    // Channel 1 traffic stays out of the channel 0 CRCs
+    CF_REG(USER_UART_CHAN_BASE(1), CF_TXDATA) = 0x5A;
+    (void)CF_REG(USER_UART_CHAN_BASE(1), CF_RXDATA);
+
+    if (CF_REG(USER_CRC_BASE, CRC_VALUE(CRC_CH_UART_TX)) != expect)
+        errors++;
+    if (CF_REG(USER_CRC_BASE, CRC_VALUE(CRC_CH_UART_RX)) != expect)
+        errors++;
+    return errors;
+}
+
+void main(){
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback, polled
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    // CRC-32 (reset defaults)
+    errors += crc_run(CRC_CTRL_SIZE32 | CRC_CTRL_REFIN | CRC_CTRL_REFOUT, 0xCBF43926);
+
+    // CRC-16/CCITT-FALSE
+    CF_REG(USER_CRC_BASE, CRC_POLY) = 0x1021;
+    CF_REG(USER_CRC_BASE, CRC_INIT) = 0xFFFF;
+    CF_REG(USER_CRC_BASE, CRC_XOROUT) = 0;
+    errors += crc_run(0, 0x29B1);
+
+    // CRC-16/ARC (reflected)
+    CF_REG(USER_CRC_BASE, CRC_POLY) = 0x8005;
+    CF_REG(USER_CRC_BASE, CRC_INIT) = 0;
+    errors += crc_run(CRC_CTRL_REFIN | CRC_CTRL_REFOUT, 0xBB3D);
+
+    UserTest_finish(errors);
+
+    return;
+}
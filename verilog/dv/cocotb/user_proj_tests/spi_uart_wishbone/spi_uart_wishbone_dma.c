@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+
+// User project Wishbone windows
+#define USER_BASE       0x30000000
+#define DMA_BUF_BASE    (USER_BASE + 0x2000)
+#define reg_dma_src     (*(volatile uint32_t*)(USER_BASE + 0xF080))
+#define reg_dma_dst     (*(volatile uint32_t*)(USER_BASE + 0xF084))
+#define reg_dma_len     (*(volatile uint32_t*)(USER_BASE + 0xF088))
+#define reg_dma_stride  (*(volatile uint32_t*)(USER_BASE + 0xF08C))
+#define reg_dma_ctrl    (*(volatile uint32_t*)(USER_BASE + 0xF090))
+#define reg_dma_status  (*(volatile uint32_t*)(USER_BASE + 0xF094))
+#define reg_irqc_ctrl   (*(volatile uint32_t*)(USER_BASE + 0xF0A0))
+#define reg_irqc_cause  (*(volatile uint32_t*)(USER_BASE + 0xF0AC))
+
+#define DMA_CTRL_START  0x1
+#define DMA_CTRL_IRQ_EN 0x8
+#define DMA_STATUS_BUSY 0x1
+#define DMA_STATUS_DONE 0x2
+#define IRQC_SRC_DMA    0x4
+
+#define DMA_TEST_WORDS  8
+
+void main(){
+    volatile uint32_t *buf = (volatile uint32_t*)DMA_BUF_BASE;
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // Fill the first half of the DMA buffer with a known pattern
+    for (int i = 0; i < DMA_TEST_WORDS; i++) {
+        buf[i] = 0xA5000000 | (i << 16) | (i << 8) | i;
+        buf[DMA_TEST_WORDS + i] = 0;
+    }
+
+    // Route DMA completion to irq[2] through the coalescer (threshold 1)
+    reg_irqc_ctrl = IRQC_SRC_DMA;
+
+    // Copy it byte by byte into the second half of the buffer
+    reg_dma_src = 0x2000;
+    reg_dma_dst = 0x2000 + DMA_TEST_WORDS * 4;
+    reg_dma_len = DMA_TEST_WORDS * 4;
+    reg_dma_stride = (1 << 16) | 1;
+    reg_dma_ctrl = DMA_CTRL_START | DMA_CTRL_IRQ_EN;
+
+    while (!(reg_dma_status & DMA_STATUS_DONE));
+
+    for (int i = 0; i < DMA_TEST_WORDS; i++) {
+        if (buf[DMA_TEST_WORDS + i] != buf[i])
+            errors++;
+    }
+
+    if (!(reg_irqc_cause & IRQC_SRC_DMA))
+        errors++;
+
+    reg_dma_status = DMA_STATUS_DONE; // clear done
+    reg_irqc_cause = IRQC_SRC_DMA;    // acknowledge, drops irq[2]
+
+    // A zero-length transfer completes at once
+    reg_dma_len = 0;
+    reg_dma_ctrl = DMA_CTRL_START;
+    int t;
+    for (t = 0; t < 100 && !(reg_dma_status & DMA_STATUS_DONE); t++);
+    if (t == 100 || (reg_dma_status & DMA_STATUS_BUSY))
+        errors++;
+    reg_dma_status = DMA_STATUS_DONE;
+
+    UserTest_finish(errors);
+
+    return;
+}
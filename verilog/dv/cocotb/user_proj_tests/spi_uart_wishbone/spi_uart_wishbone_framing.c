@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+// Payload full of SLIP specials and zeros
+static const uint8_t frame[12] = {0xC0, 0x01, 0xDB, 0x00, 0x00, 0xDC, 0xDD, 0x7E,
+                                  0x00, 0xC0, 0xDB, 0x00};
+
+// Send the frame through the UART loopback and check what comes back
+static int frame_loop(int cobs){
+    uint8_t rx[16];
+    int errors = 0;
+    int len;
+
+    UserFrame_enable(cobs);
+    if (UserFrame_send(frame, 12) != 12)
+        errors++;
+
+    while (!(CF_REG(USER_FRM_BASE, FRM_STATUS) & FRM_STATUS_FRAME))
+        ;
+    len = UserFrame_recv(rx, 16);
+    if (len != 12)
+        errors++;
+    for (int i = 0; i < 12; i++)
+        if (rx[i] != frame[i])
+            errors++;
+
+    while (!(CF_REG(USER_FRM_BASE, FRM_STATUS) & FRM_STATUS_TX_IDLE))
+        ;
+    CF_REG(USER_FRM_BASE, FRM_CTRL) = 0;
+    return errors;
+}
+
+void main(){
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback; the framer owns its FIFOs
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    errors += frame_loop(0);    // SLIP
+    errors += frame_loop(1);    // COBS
+
+    // With EN clear nothing drains. In COBS mode each zero takes a code
+    // entry and the code queue fills after 15, so the 16th is dropped.
+    CF_REG(USER_FRM_BASE, FRM_CTRL) = FRM_CTRL_COBS;
+    for (int i = 0; i < 15; i++)
+        CF_REG(USER_FRM_BASE, FRM_TXDATA) = 0x00;
+    if ((CF_REG(USER_FRM_BASE, FRM_STATUS) & (FRM_STATUS_TX_FULL | FRM_STATUS_TX_OVERFLOW)) !=
+        FRM_STATUS_TX_FULL)
+        errors++;
+    CF_REG(USER_FRM_BASE, FRM_TXDATA) = 0x00;
+    if (!(CF_REG(USER_FRM_BASE, FRM_STATUS) & FRM_STATUS_TX_OVERFLOW))
+        errors++;
+    CF_REG(USER_FRM_BASE, FRM_STATUS) = FRM_STATUS_TX_OVERFLOW;
+    if (CF_REG(USER_FRM_BASE, FRM_STATUS) & FRM_STATUS_TX_OVERFLOW)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
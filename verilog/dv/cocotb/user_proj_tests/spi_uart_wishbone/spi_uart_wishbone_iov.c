@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+void main(){
+    static const uint8_t hdr[3] = {0x7E, 0x01, 0x10};
+    static const uint8_t body[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                     0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+    uint8_t rx_hdr[3];
+    uint8_t rx_body[16];
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback, interrupts left masked by the polled path
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    // A header and a body sent from where they are, received straight
+    // into separate buffers. 19 bytes is more than one FIFO's worth, so
+    // the receive side has to drain while the send side is still going:
+    // send the header and the first half of the body, collect them, then
+    // send and collect the rest.
+    const UserIovec tx1[2] = {{(void*)hdr, 3}, {(void*)body, 8}};
+    const UserIovec rx1[2] = {{rx_hdr, 3}, {rx_body, 8}};
+    const UserIovec tx2[1] = {{(void*)(body + 8), 8}};
+    const UserIovec rx2[1] = {{rx_body + 8, 8}};
+
+    if (UserUart_writev(tx1, 2) != 11)
+        errors++;
+    if (UserUart_readv(rx1, 2) != 11)
+        errors++;
+    if (UserUart_writev(tx2, 1) != 8)
+        errors++;
+    if (UserUart_readv(rx2, 1) != 8)
+        errors++;
+
+    for (int i = 0; i < 3; i++)
+        if (rx_hdr[i] != hdr[i])
+            errors++;
+    for (int i = 0; i < 16; i++)
+        if (rx_body[i] != body[i])
+            errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
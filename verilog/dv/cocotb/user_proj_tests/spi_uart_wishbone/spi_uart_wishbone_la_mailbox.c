@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+#define LAM_TEST_LEN    21
+
+void main(){
+    int errors = 0;
+    uint8_t tx[LAM_TEST_LEN];
+    uint8_t rx[LAM_TEST_LEN + LAM_POP_MAX];
+    int got = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback, polled
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    for (int i = 0; i < LAM_TEST_LEN; i++)
+        tx[i] = 0x30 + 7 * i;
+
+    UserLa_enable(1);
+
+    // A full 16-byte push, then a short one queued behind it
+    UserLa_push(1, tx, 16);
+    UserLa_push(1, tx + 16, LAM_TEST_LEN - 16);
+
+    for (int t = 0; t < 1000 && got < LAM_TEST_LEN; t++)
+        got += UserLa_pop(1, rx + got);
+
+    if (got != LAM_TEST_LEN)
+        errors++;
+    for (int i = 0; i < got && i < LAM_TEST_LEN; i++)
+        if (rx[i] != tx[i])
+            errors++;
+
+    // Nothing left behind
+    if (UserLa_pop(1, rx) != 0)
+        errors++;
+
+    UserLa_enable(0);
+
+    UserTest_finish(errors);
+
+    return;
+}
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+
+// User project Wishbone windows
+#define USER_BASE          0x30000000
+#define reg_uart_txdata    (*(volatile uint32_t*)(USER_BASE + 0x1004))
+#define reg_perf_ctrl      (*(volatile uint32_t*)(USER_BASE + 0xF010))
+#define reg_perf_wb_access (*(volatile uint32_t*)(USER_BASE + 0xF014))
+#define reg_perf_spi_tx    (*(volatile uint32_t*)(USER_BASE + 0xF01C))
+#define reg_perf_uart_tx   (*(volatile uint32_t*)(USER_BASE + 0xF024))
+
+#define PERF_CTRL_SNAPSHOT 0x1
+
+#define PERF_TEST_BYTES    4
+
+void main(){
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // Start a fresh interval
+    reg_perf_ctrl = PERF_CTRL_SNAPSHOT;
+
+    for (int i = 0; i < PERF_TEST_BYTES; i++)
+        reg_uart_txdata = 0x30 + i;
+
+    // Sample the interval and check the counters it covered
+    reg_perf_ctrl = PERF_CTRL_SNAPSHOT;
+
+    if (reg_perf_uart_tx != PERF_TEST_BYTES)
+        errors++;
+    if (reg_perf_spi_tx != 0)
+        errors++;
+    if (reg_perf_wb_access < PERF_TEST_BYTES)
+        errors++;
+
+    // Nothing was sent since the last snapshot
+    reg_perf_ctrl = PERF_CTRL_SNAPSHOT;
+
+    if (reg_perf_uart_tx != 0)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
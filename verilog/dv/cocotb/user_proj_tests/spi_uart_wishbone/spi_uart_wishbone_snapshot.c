@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+// Poll SNAPSHOT until cond holds or the retries run out
+#define SNAP_WAIT(s, cond) \
+    do { int t_ = 1000; do { s = UserStatus_snapshot(); } while (!(cond) && --t_); } while (0)
+
+void main(){
+    int errors = 0;
+    uint32_t s;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // UART in internal loopback, polled
+    UserUart_init(1, 1);
+    CF_REG(USER_UART_BASE, CF_IM) = 0;
+
+    if (UserStatus_snapshot() & SNAP_VALID)
+        errors++;
+
+    UserStatus_poll(1);
+    SNAP_WAIT(s, s & SNAP_VALID);
+    if (!(s & SNAP_VALID))
+        errors++;
+    if (SNAP_UART_RX_LEVEL(s) != 0 || SNAP_UART_TX_LEVEL(s) != 0)
+        errors++;
+
+    // Three bytes come back through the loopback
+    CF_REG(USER_UART_BASE, CF_TXDATA) = 0xA5;
+    CF_REG(USER_UART_BASE, CF_TXDATA) = 0x5A;
+    CF_REG(USER_UART_BASE, CF_TXDATA) = 0x3C;
+
+    SNAP_WAIT(s, SNAP_UART_RX_LEVEL(s) == 3);
+    if (SNAP_UART_RX_LEVEL(s) != 3 || SNAP_UART_TX_LEVEL(s) != 0)
+        errors++;
+    if (CF_REG(USER_UART_BASE, CF_RX_FIFO_LEVEL) != 3)
+        errors++;
+    if (s & (SNAP_UART_FE | SNAP_UART_PE | SNAP_UART_OR | SNAP_UART_BRK))
+        errors++;
+    if (s & SNAP_IRQ_UART0)
+        errors++;
+
+    for (int i = 0; i < 3; i++)
+        (void)CF_REG(USER_UART_BASE, CF_RXDATA);
+
+    SNAP_WAIT(s, SNAP_UART_RX_LEVEL(s) == 0);
+    if (SNAP_UART_RX_LEVEL(s) != 0)
+        errors++;
+
+    UserStatus_poll(0);
+    SNAP_WAIT(s, !(s & SNAP_VALID));
+    if (s & SNAP_VALID)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
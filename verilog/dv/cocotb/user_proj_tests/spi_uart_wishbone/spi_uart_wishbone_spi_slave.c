@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+#include "../common/spi_uart_drv.h"
+
+#define USER_SSLV_BASE      (USER_BASE_ADDR + 0xE000)
+#define SSLV_STATUS         0x014
+#define SSLV_STATUS_OVERRUN 0x20
+#define SSLV_STATUS_UNDERRUN 0x40
+#define CONTROL_SPI_SLAVE   (1 << 2)
+
+#define reg_user_control    (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF004))
+#define reg_perf_ctrl       (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF010))
+#define reg_perf_overrun    (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF034))
+#define reg_perf_underrun   (*(volatile uint32_t*)(USER_BASE_ADDR + 0xF038))
+#define PERF_CTRL_SNAPSHOT  0x1
+
+void main(){
+    // The testbench sends 0x5A, 0xC3, 0x0F, 0xF0, 0x99 and expects these
+    // back, then 0xFF for the fifth byte, which underruns
+    static const uint8_t reply[4] = {0xA5, 0x3C, 0x81, 0x7E};
+    static const uint8_t expect[5] = {0x5A, 0xC3, 0x0F, 0xF0, 0x99};
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+
+    // Slave mode, CPOL = CPHA = 0, replies queued before the host starts
+    reg_user_control = reg_user_control | CONTROL_SPI_SLAVE;
+    for (int i = 0; i < 4; i++)
+        CF_REG(USER_SSLV_BASE, CF_TXDATA) = reply[i];
+
+    reg_perf_ctrl = PERF_CTRL_SNAPSHOT; // start a clean interval
+
+    ManagmentGpio_write(1); // configuration finished, host may start
+
+    while (CF_REG(USER_SSLV_BASE, CF_RX_FIFO_LEVEL) < 5)
+        ;
+    for (int i = 0; i < 5; i++)
+        if ((CF_REG(USER_SSLV_BASE, CF_RXDATA) & 0xFF) != expect[i])
+            errors++;
+
+    if ((CF_REG(USER_SSLV_BASE, SSLV_STATUS) & (SSLV_STATUS_OVERRUN | SSLV_STATUS_UNDERRUN)) !=
+        SSLV_STATUS_UNDERRUN)
+        errors++;
+
+    // One byte sent empty, none dropped
+    reg_perf_ctrl = PERF_CTRL_SNAPSHOT;
+    if (reg_perf_underrun != 1 || reg_perf_overrun != 0)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2023 Efabless Corporation
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include <firmware_apis.h>
+#include "../common/user_gpio_cfg.h"
+#include "../common/selfcheck.h"
+
+// User project Wishbone windows
+#define USER_BASE          0x30000000
+#define DMA_BUF_BASE       (USER_BASE + 0x2000)
+#define reg_trace_ctrl     (*(volatile uint32_t*)(USER_BASE + 0xF0C0))
+#define reg_trace_trig     (*(volatile uint32_t*)(USER_BASE + 0xF0C4))
+#define reg_trace_mask     (*(volatile uint32_t*)(USER_BASE + 0xF0C8))
+#define reg_trace_post     (*(volatile uint32_t*)(USER_BASE + 0xF0CC))
+#define reg_trace_status   (*(volatile uint32_t*)(USER_BASE + 0xF0D0))
+#define reg_trace_idx      (*(volatile uint32_t*)(USER_BASE + 0xF0D4))
+#define reg_trace_data0    (*(volatile uint32_t*)(USER_BASE + 0xF0D8))
+#define reg_trace_data1    (*(volatile uint32_t*)(USER_BASE + 0xF0DC))
+
+#define TRACE_CTRL_ARM     0x001
+#define TRACE_CTRL_EV_WB   0x100
+#define TRACE_STATUS_DONE  0x4
+
+void main(){
+    volatile uint32_t *buf = (volatile uint32_t*)DMA_BUF_BASE;
+    int errors = 0;
+
+    // Enable management gpio as output to use as indicator for finishing configuration  
+    ManagmentGpio_outputEnable();
+    ManagmentGpio_write(0);
+    enableHkSpi(0); // disable housekeeping spi
+    User_enableIF(1); // enable the user project Wishbone interface
+
+
+    UserGpio_configure(); // one-shot pin table load
+    ManagmentGpio_write(1); // configuration finished 
+
+    // TRACE_POST saturates one short of the ring size, so the trigger
+    // entry survives; that includes values whose low bits alone would
+    // look small
+    reg_trace_post = 0x20;
+    if (reg_trace_post != 31)
+        errors++;
+    reg_trace_post = 0x40;
+    if (reg_trace_post != 31)
+        errors++;
+    reg_trace_post = 0x10021;
+    if (reg_trace_post != 31)
+        errors++;
+
+    // Trace Wishbone accesses, trigger on a write to buffer word 4,
+    // keep two accesses after it
+    reg_trace_trig = 0x2010;
+    reg_trace_mask = 0xFFFF;
+    reg_trace_post = 2;
+    reg_trace_ctrl = TRACE_CTRL_EV_WB | TRACE_CTRL_ARM;
+
+    for (int i = 0; i < 8; i++)
+        buf[i] = 0xC0DE0000 | i;
+
+    uint32_t status = reg_trace_status;
+    if (!(status & TRACE_STATUS_DONE))
+        errors++;
+
+    // The trigger entry holds the write to word 4
+    reg_trace_idx = (status >> 16) & 0xFF;
+    if (reg_trace_data0 != 0xC0DE0004)
+        errors++;
+    if ((reg_trace_data1 & 0xF800FFFF) != 0x18002010) // type 1, WE, address
+        errors++;
+
+    // Capture stopped after word 6
+    reg_trace_idx = ((status >> 8) - 1) & 0xFF;
+    if (reg_trace_data0 != 0xC0DE0006)
+        errors++;
+
+    UserTest_finish(errors);
+
+    return;
+}
@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Quad SPI memory on the QSPI pads (IO0-IO3 on io[5], io[6], io[15],
+// io[16]). Each command starts at address 0 after CSB falls:
+//
+//   0x32  quad write: x1 opcode, then x4 data bytes
+//   0x6B  quad read: x1 opcode, DUMMY_CLOCKS dummy clocks, then x4
+//         data bytes, put out on the falling SCLK edge
+//
+// Nibbles go high first, IO3 carrying the top bit. Besides the data,
+// the model checks the pad directions: the project must drive IO0 for
+// the opcode and all four lanes on every write clock, and must have all
+// four released on every cycle the model drives them.
+
+#ifndef QSPI_FLASH_H
+#define QSPI_FLASH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "user_proj_sim.h"
+
+class QspiFlash : public PinModel {
+public:
+    enum { PIN_IO0 = 5, PIN_IO1 = 6, PIN_SCLK = 7, PIN_CSB = 8, PIN_IO2 = 15, PIN_IO3 = 16 };
+    enum { CMD_QUAD_WRITE = 0x32, CMD_QUAD_READ = 0x6B, DUMMY_CLOCKS = 2 };
+
+    explicit QspiFlash(unsigned size) : mem(size, 0xFF) {}
+
+    void step(UserProjSim& sim) override {
+        const bool csb = sim.pin(PIN_CSB);
+        const bool sclk = sim.pin(PIN_SCLK);
+
+        if (csb) {
+            state_ = S_OPCODE;
+            bits_ = 0;
+            addr_ = 0;
+            drive_ = false;
+        } else if (sclk && !sclk_q_) {
+            rising(sim);
+        } else if (!sclk && sclk_q_ && state_ == S_READ && !dummy_) {
+            // Next nibble goes out on the falling edge
+            const uint8_t b = mem[addr_ % mem.size()];
+            out_ = low_ ? (b & 0xF) : (b >> 4);
+            drive_ = true;
+        }
+
+        if (drive_) {
+            if (!released(sim))
+                contention++;
+            sim.set_pin(PIN_IO0, out_ & 1);
+            sim.set_pin(PIN_IO1, (out_ >> 1) & 1);
+            sim.set_pin(PIN_IO2, (out_ >> 2) & 1);
+            sim.set_pin(PIN_IO3, (out_ >> 3) & 1);
+        }
+
+        sclk_q_ = sclk;
+    }
+
+    std::vector<uint8_t> mem;
+    uint64_t contention = 0;        // model driving while a lane was an output
+    uint64_t direction_errors = 0;  // lane not driven when the model samples it
+    uint64_t bad_opcodes = 0;
+
+private:
+    enum State { S_OPCODE, S_WRITE, S_READ, S_IGNORE };
+
+    static bool released(UserProjSim& sim) {
+        return sim.oeb(PIN_IO0) && sim.oeb(PIN_IO1) && sim.oeb(PIN_IO2) && sim.oeb(PIN_IO3);
+    }
+
+    static bool driven(UserProjSim& sim) {
+        return !sim.oeb(PIN_IO0) && !sim.oeb(PIN_IO1) && !sim.oeb(PIN_IO2) && !sim.oeb(PIN_IO3);
+    }
+
+    void rising(UserProjSim& sim) {
+        switch (state_) {
+        case S_OPCODE:
+            if (sim.oeb(PIN_IO0))
+                direction_errors++;
+            opcode_ = (uint8_t)((opcode_ << 1) | sim.pin(PIN_IO0));
+            if (++bits_ < 8)
+                break;
+            low_ = false;
+            if (opcode_ == CMD_QUAD_WRITE) {
+                state_ = S_WRITE;
+            } else if (opcode_ == CMD_QUAD_READ) {
+                state_ = S_READ;
+                dummy_ = DUMMY_CLOCKS;
+            } else {
+                bad_opcodes++;
+                state_ = S_IGNORE;
+            }
+            break;
+
+        case S_WRITE: {
+            if (!driven(sim))
+                direction_errors++;
+            const uint8_t nib = (uint8_t)((sim.pin(PIN_IO3) << 3) | (sim.pin(PIN_IO2) << 2) |
+                                          (sim.pin(PIN_IO1) << 1) | sim.pin(PIN_IO0));
+            if (!low_) {
+                byte_ = (uint8_t)(nib << 4);
+            } else {
+                mem[addr_ % mem.size()] = byte_ | nib;
+                addr_++;
+            }
+            low_ = !low_;
+            break;
+        }
+
+        case S_READ:
+            // The master samples here; move on to the next nibble
+            if (dummy_) {
+                dummy_--;
+            } else {
+                if (low_)
+                    addr_++;
+                low_ = !low_;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    State state_ = S_OPCODE;
+    bool sclk_q_ = false;
+    unsigned bits_ = 0;
+    unsigned dummy_ = 0;
+    unsigned addr_ = 0;
+    bool low_ = false;
+    bool drive_ = false;
+    uint8_t opcode_ = 0;
+    uint8_t byte_ = 0;
+    uint8_t out_ = 0;
+};
+
+#endif // QSPI_FLASH_H
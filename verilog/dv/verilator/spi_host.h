@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Mode 0 SPI host on the SPI pads, for the project's SPI slave. Each
+// SCLK phase lasts half_cycles user_clock2 cycles, and so does the gap
+// between CSB falling and the first rising edge. MOSI changes on the
+// falling edge and MISO is sampled on the rising edge. CSB stays low
+// while bytes are queued and rises one phase after the last byte.
+
+#ifndef SPI_HOST_H
+#define SPI_HOST_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "user_proj_sim.h"
+
+class SpiHost : public PinModel {
+public:
+    enum { PIN_MOSI = 5, PIN_MISO = 6, PIN_SCLK = 7, PIN_CSB = 8 };
+
+    explicit SpiHost(unsigned half_cycles) : half_(half_cycles) {}
+
+    void send(uint8_t byte) { queue_.push_back(byte); }
+    bool idle() const { return state_ == IDLE && queue_.empty(); }
+
+    void step(UserProjSim& sim) override {
+        if (wait_)
+            wait_--;
+        else
+            advance(sim);
+
+        sim.set_pin(PIN_CSB, csb_);
+        sim.set_pin(PIN_SCLK, sclk_);
+        sim.set_pin(PIN_MOSI, (out_ >> (7 - bit_)) & 1);
+    }
+
+    std::vector<uint8_t> received;
+
+private:
+    enum State { IDLE, LOW, HIGH, DESELECT };
+
+    void advance(UserProjSim& sim) {
+        switch (state_) {
+        case IDLE:
+            if (queue_.empty())
+                return;
+            csb_ = false;
+            load();
+            break;
+        case LOW:
+            sclk_ = true;
+            in_ = (uint8_t)((in_ << 1) | sim.pin(PIN_MISO));
+            state_ = HIGH;
+            break;
+        case HIGH:
+            sclk_ = false;
+            if (++bit_ < 8) {
+                state_ = LOW;
+                break;
+            }
+            received.push_back(in_);
+            bit_ = 0;
+            if (queue_.empty())
+                state_ = DESELECT;
+            else
+                load();
+            break;
+        case DESELECT:
+            csb_ = true;
+            state_ = IDLE;
+            break;
+        }
+        wait_ = half_ - 1;
+    }
+
+    void load() {
+        out_ = queue_.front();
+        queue_.pop_front();
+        bit_ = 0;
+        state_ = LOW;
+    }
+
+    unsigned half_;
+    State state_ = IDLE;
+    unsigned wait_ = 0;
+    bool csb_ = true;
+    bool sclk_ = false;
+    unsigned bit_ = 0;
+    uint8_t out_ = 0;
+    uint8_t in_ = 0;
+    std::deque<uint8_t> queue_;
+};
+
+#endif // SPI_HOST_H
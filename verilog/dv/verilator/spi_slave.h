@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Mode 0 SPI slave on the SPI pads. MOSI is sampled on the SCLK rising
+// edge and MISO changes on the falling edge. Each byte clocked out is
+// the byte received before it (0xFF for the first byte after reset),
+// so the master reads back its own stream delayed by one byte.
+
+#ifndef SPI_SLAVE_H
+#define SPI_SLAVE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "user_proj_sim.h"
+
+class SpiSlave : public PinModel {
+public:
+    enum { PIN_MOSI = 5, PIN_MISO = 6, PIN_SCLK = 7, PIN_CSB = 8 };
+
+    void step(UserProjSim& sim) override {
+        const bool csb = sim.pin(PIN_CSB);
+        const bool sclk = sim.pin(PIN_SCLK);
+
+        if (!csb) {
+            if (csb_q_) {
+                // Select: first bit goes out before the first rising edge
+                bits_ = 0;
+                out_ = reply_;
+            } else if (sclk && !sclk_q_) {
+                in_ = (uint8_t)((in_ << 1) | sim.pin(PIN_MOSI));
+                if (++bits_ == 8) {
+                    received.push_back(in_);
+                    reply_ = in_;
+                    bits_ = 0;
+                }
+            } else if (!sclk && sclk_q_) {
+                out_ = bits_ ? (uint8_t)(out_ << 1) : reply_;
+            }
+        }
+        sim.set_pin(PIN_MISO, (out_ >> 7) & 1);
+
+        csb_q_ = csb;
+        sclk_q_ = sclk;
+    }
+
+    std::vector<uint8_t> received;
+
+private:
+    bool csb_q_ = true;
+    bool sclk_q_ = false;
+    unsigned bits_ = 0;
+    uint8_t in_ = 0;
+    uint8_t out_ = 0xFF;
+    uint8_t reply_ = 0xFF;
+};
+
+#endif // SPI_SLAVE_H
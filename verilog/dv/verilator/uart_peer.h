@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// 8N1 UART on the far side of a channel's pads. Bit time is counted in
+// user_clock2 cycles. Received bytes are logged and, with echo enabled,
+// sent straight back.
+
+#ifndef UART_PEER_H
+#define UART_PEER_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "user_proj_sim.h"
+
+class UartPeer : public PinModel {
+public:
+    // tx_pin is the project's TX pad (our input), rx_pin its RX pad
+    UartPeer(int tx_pin, int rx_pin, unsigned bit_cycles, bool echo)
+        : tx_pin_(tx_pin), rx_pin_(rx_pin), bit_(bit_cycles), echo_(echo) {}
+
+    void send(uint8_t byte) { tx_queue_.push_back(byte); }
+
+    // Change only while both directions are idle
+    void set_bit_cycles(unsigned bit_cycles) { bit_ = bit_cycles; }
+
+    void step(UserProjSim& sim) override {
+        receive(sim.pin(tx_pin_));
+        sim.set_pin(rx_pin_, transmit());
+    }
+
+    std::vector<uint8_t> received;
+    uint64_t framing_errors = 0;
+
+private:
+    void receive(bool line) {
+        if (rx_bit_ < 0) {
+            // Idle: a low level starts a frame, sampled mid-bit from here on
+            if (!line) {
+                rx_bit_ = 0;
+                rx_cnt_ = bit_ / 2;
+            }
+            return;
+        }
+        if (rx_cnt_--)
+            return;
+        rx_cnt_ = bit_ - 1;
+
+        if (rx_bit_ == 0) {
+            if (line)
+                rx_bit_ = -1;   // glitch, not a start bit
+            else
+                rx_bit_++;
+        } else if (rx_bit_ <= 8) {
+            rx_data_ = (uint8_t)((rx_data_ >> 1) | (line ? 0x80 : 0));
+            rx_bit_++;
+        } else {
+            if (!line)
+                framing_errors++;
+            received.push_back(rx_data_);
+            if (echo_)
+                tx_queue_.push_back(rx_data_);
+            rx_bit_ = -1;
+        }
+    }
+
+    bool transmit() {
+        if (tx_bit_ < 0) {
+            if (tx_queue_.empty())
+                return true;
+            tx_frame_ = (uint16_t)((1u << 9) | ((unsigned)tx_queue_.front() << 1));
+            tx_queue_.pop_front();
+            tx_bit_ = 0;
+            tx_cnt_ = bit_;
+        }
+        const bool level = (tx_frame_ >> tx_bit_) & 1;
+        if (--tx_cnt_ == 0) {
+            tx_cnt_ = bit_;
+            if (++tx_bit_ == 10)
+                tx_bit_ = -1;
+        }
+        return level;
+    }
+
+    int tx_pin_;
+    int rx_pin_;
+    unsigned bit_;
+    bool echo_;
+
+    int rx_bit_ = -1;
+    unsigned rx_cnt_ = 0;
+    uint8_t rx_data_ = 0;
+
+    std::deque<uint8_t> tx_queue_;
+    int tx_bit_ = -1;
+    unsigned tx_cnt_ = 0;
+    uint16_t tx_frame_ = 0;
+};
+
+#endif // UART_PEER_H
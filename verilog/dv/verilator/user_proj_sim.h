@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Clock, reset and pad plumbing around the Verilated user_proj_example.
+//
+// wb_clk_i and user_clock2 run from one time base with independent half
+// periods. Pin models are stepped on every user_clock2 rising edge, the
+// clock the SPI/UART pads are registered on.
+//
+// With a SAVABLE=1 build, save() and restore() checkpoint the model
+// together with the clock state, so a run can start from a stored
+// post-boot state instead of repeating reset and setup.
+
+#ifndef USER_PROJ_SIM_H
+#define USER_PROJ_SIM_H
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Vuser_proj_example.h"
+#include "verilated.h"
+#if VM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+#if USER_PROJ_SAVABLE
+#include "verilated_save.h"
+#endif
+
+// First GPIO routed to the user project (io_in/io_out are [37:5])
+#define USER_IO_BASE 5
+
+class UserProjSim;
+
+class PinModel {
+public:
+    virtual ~PinModel() {}
+    virtual void step(UserProjSim& sim) = 0;
+};
+
+class UserProjSim {
+public:
+    UserProjSim(unsigned wb_half, unsigned ser_half, const char* vcd)
+        : top(new Vuser_proj_example),
+          wb_half_(wb_half), ser_half_(ser_half),
+          next_wb_(wb_half), next_ser_(ser_half)
+    {
+        top->wb_clk_i = 0;
+        top->user_clock2 = 0;
+        top->wb_rst_i = 1;
+        top->wbs_cyc_i = 0;
+        top->wbs_stb_i = 0;
+        top->wbs_we_i = 0;
+        top->wbs_sel_i = 0;
+        top->wbs_adr_i = 0;
+        top->wbs_dat_i = 0;
+        for (int i = 0; i < 4; i++) {
+            top->la_data_in[i] = 0;
+            top->la_oenb[i] = 0xFFFFFFFF;
+        }
+        top->io_in = 0;
+#if VM_TRACE
+        if (vcd) {
+            Verilated::traceEverOn(true);
+            vcd_.reset(new VerilatedVcdC);
+            top->trace(vcd_.get(), 99);
+            vcd_->open(vcd);
+        }
+#else
+        if (vcd)
+            throw std::runtime_error("VCD requested but the harness was built without TRACE=1");
+#endif
+        top->eval();
+    }
+
+    ~UserProjSim() {
+        top->final();
+#if VM_TRACE
+        if (vcd_)
+            vcd_->close();
+#endif
+    }
+
+    void add_model(PinModel* model) { models_.push_back(model); }
+
+    // Pads, by Caravel GPIO number
+    bool pin(int n) const { return (top->io_out >> (n - USER_IO_BASE)) & 1; }
+    bool oeb(int n) const { return (top->io_oeb >> (n - USER_IO_BASE)) & 1; }
+    void set_pin(int n, bool v) {
+        const uint64_t bit = 1ULL << (n - USER_IO_BASE);
+        top->io_in = v ? (top->io_in | bit) : (top->io_in & ~bit);
+    }
+
+    // Advance to the next wb_clk_i rising edge
+    void tick() {
+        for (;;) {
+            const uint64_t t = next_wb_ < next_ser_ ? next_wb_ : next_ser_;
+            bool wb_rise = false;
+            bool ser_rise = false;
+
+            time_ = t;
+            if (next_wb_ == t) {
+                top->wb_clk_i = !top->wb_clk_i;
+                wb_rise = top->wb_clk_i;
+                next_wb_ += wb_half_;
+            }
+            if (next_ser_ == t) {
+                top->user_clock2 = !top->user_clock2;
+                ser_rise = top->user_clock2;
+                next_ser_ += ser_half_;
+            }
+            top->eval();
+
+            if (ser_rise) {
+                ser_cycles++;
+                for (PinModel* m : models_)
+                    m->step(*this);
+                top->eval();
+            }
+#if VM_TRACE
+            if (vcd_)
+                vcd_->dump(time_);
+#endif
+            if (wb_rise) {
+                wb_cycles++;
+                if (max_cycles && wb_cycles > max_cycles)
+                    throw std::runtime_error("cycle limit reached");
+                return;
+            }
+        }
+    }
+
+    void run(uint64_t cycles) {
+        while (cycles--)
+            tick();
+    }
+
+    // Hold wb_rst_i long enough for the user_clock2 reset synchroniser
+    void reset(unsigned cycles = 16) {
+        top->wb_rst_i = 1;
+        run(cycles);
+        top->wb_rst_i = 0;
+        run(cycles);
+    }
+
+    // Checkpoints hold the model and the clock state only; pin models
+    // are expected to be idle at the point of the save
+    void save(const char* path) {
+#if USER_PROJ_SAVABLE
+        VerilatedSave os;
+        os.open(path);
+        os << wb_half_ << ser_half_ << next_wb_ << next_ser_ << time_;
+        os << wb_cycles << ser_cycles;
+        os << *top;
+        os.close();
+#else
+        (void)path;
+        throw std::runtime_error("checkpoints need a SAVABLE=1 build");
+#endif
+    }
+
+    void restore(const char* path) {
+#if USER_PROJ_SAVABLE
+        VerilatedRestore os;
+        unsigned wb_half, ser_half;
+        os.open(path);
+        if (!os.isOpen())
+            throw std::runtime_error("cannot open checkpoint");
+        os >> wb_half >> ser_half;
+        if (wb_half != wb_half_ || ser_half != ser_half_)
+            throw std::runtime_error("checkpoint was taken with different clock periods");
+        os >> next_wb_ >> next_ser_ >> time_;
+        os >> wb_cycles >> ser_cycles;
+        os >> *top;
+        os.close();
+        top->eval();
+#else
+        (void)path;
+        throw std::runtime_error("checkpoints need a SAVABLE=1 build");
+#endif
+    }
+
+    std::unique_ptr<Vuser_proj_example> top;
+    uint64_t wb_cycles = 0;
+    uint64_t ser_cycles = 0;
+    uint64_t max_cycles = 0;
+
+private:
+    unsigned wb_half_;
+    unsigned ser_half_;
+    uint64_t next_wb_;
+    uint64_t next_ser_;
+    uint64_t time_ = 0;
+    std::vector<PinModel*> models_;
+#if VM_TRACE
+    std::unique_ptr<VerilatedVcdC> vcd_;
+#endif
+};
+
+#endif // USER_PROJ_SIM_H
@@ -0,0 +1,1024 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Standalone harness for user_proj_example: no management core, no
+// firmware and no GPIO configuration. A C++ Wishbone master plays the
+// firmware part against an SPI slave and a UART peer on the pads.
+//
+//   Vuser_proj_example [--test smoke|spi|uart|uart1|irqc|baud|bridge|qspi|sslv|crc|
+//                             framer|snapshot|clkgate|la|all]
+//                      [--bytes N] [--spi-pr N] [--uart-pr N] [--ser-half N]
+//                      [--max-cycles N] [--vcd FILE]
+//                      [--save FILE | --restore FILE]
+//
+// --vcd needs a TRACE=1 build and is best used with a single --test.
+// --save stores the state reached after boot and --restore starts every
+// workload from it instead of booting; both need a SAVABLE=1 build.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "qspi_flash.h"
+#include "spi_host.h"
+#include "spi_slave.h"
+#include "uart_peer.h"
+#include "user_proj_sim.h"
+#include "wb_bfm.h"
+
+// User project address map
+#define SPI_BASE        0x0000
+#define UART_BASE       0x1000
+#define BUF_BASE        0x2000
+#define QSPI_BASE       0x3000
+#define SSLV_BASE       0xE000
+#define CTRL_BASE       0xF000
+
+#define UART1_BASE      0x4000
+#define STATUS_REG      (CTRL_BASE + 0x00)
+#define CONTROL_REG     (CTRL_BASE + 0x04)
+#define VERSION_REG     (CTRL_BASE + 0x08)
+#define VERSION_VALUE   0x01000000
+#define UART_IRQ_REG    (CTRL_BASE + 0x0C)
+#define PERF_CTRL       (CTRL_BASE + 0x10)
+#define PERF_SSLV_OVERRUN  (CTRL_BASE + 0x34)
+#define PERF_SSLV_UNDERRUN (CTRL_BASE + 0x38)
+#define PERF_SNAPSHOT   0x1
+#define SNAPSHOT_REG    (CTRL_BASE + 0x40)
+#define SNAP_UART_RX_LEVEL(s)   (((s) >> 10) & 0x1F)
+#define SNAP_UART_TX_LEVEL(s)   (((s) >> 15) & 0x1F)
+#define SNAP_UART_ERRORS        (0xFu << 20)
+#define SNAP_IRQ_UART0          (1u << 27)
+#define SNAP_VALID              (1u << 31)
+#define IRQC_CTRL       (CTRL_BASE + 0xA0)
+#define IRQC_THRESH     (CTRL_BASE + 0xA4)
+#define IRQC_CAUSE      (CTRL_BASE + 0xAC)
+#define IRQC_COUNT      (CTRL_BASE + 0xB0)
+#define IRQC_SRC_UART   0x2
+#define BAUD_CTRL       (CTRL_BASE + 0x100)
+#define BAUD_FRAC       (CTRL_BASE + 0x104)
+#define BAUD_STATUS     (CTRL_BASE + 0x108)
+#define BAUD_MEAS       (CTRL_BASE + 0x10C)
+#define BAUD_FRAC_EN    0x1
+#define BAUD_AUTO       0x2
+#define BAUD_BUSY       0x1
+#define BAUD_DONE       0x2
+#define CRC_CTRL        (CTRL_BASE + 0x120)
+#define CRC_POLY        (CTRL_BASE + 0x124)
+#define CRC_INIT        (CTRL_BASE + 0x128)
+#define CRC_XOROUT      (CTRL_BASE + 0x12C)
+#define CRC_VALUE(ch)   (CTRL_BASE + 0x130 + 4 * (ch))
+#define CRC_SIZE32      0x1
+#define CRC_REFIN       0x2
+#define CRC_REFOUT      0x4
+#define CRC_EN(ch)      (1 << (4 + (ch)))
+#define CRC_RST(ch)     (1 << (8 + (ch)))
+#define CRC_CH_UART_TX  2
+#define CRC_CH_UART_RX  3
+#define FRM_CTRL        (CTRL_BASE + 0x140)
+#define FRM_TXDATA      (CTRL_BASE + 0x144)
+#define FRM_RXDATA      (CTRL_BASE + 0x148)
+#define FRM_RXLEN       (CTRL_BASE + 0x14C)
+#define FRM_STATUS      (CTRL_BASE + 0x150)
+#define FRM_EN          0x1
+#define FRM_COBS        0x2
+#define FRM_TX_END      0x100
+#define FRM_RXLEN_ERROR (1u << 30)
+#define FRM_RXLEN_VALID (1u << 31)
+#define FRM_TX_FULL     (1 << 9)
+#define FRM_TX_IDLE     (1 << 10)
+#define FRM_TX_OVERFLOW (1 << 11)
+#define FRM_FRAME       (1 << 24)
+
+#define CONTROL_BRIDGE  0x3     // SPI -> UART and UART -> SPI
+#define CONTROL_SPI_SLAVE 0x4
+#define CONTROL_STATUS_POLL 0x8
+#define CONTROL_CLK_GATE 0x30   // SPI and UART core clocks
+#define CONTROL_CLK_IDLE(n) ((n) << 12)
+#define STATUS_CLK_OFF  0x30    // SPI and all UART core clocks stopped
+#define CONTROL_LA_MAILBOX 0x100
+
+// CF IP registers (window offsets)
+#define IP_RXDATA       0x000
+#define IP_TXDATA       0x004
+#define IP_RX_LEVEL     0xE00
+#define IP_TX_LEVEL     0xE10
+#define IP_RX_THRESH    0xE04
+#define IP_IM           0xF00
+#define IP_IC           0xF0C
+
+#define UART_PR         0x008
+#define UART_CTRL       0x00C
+#define UART_CTRL_EN    0x7     // EN | TXEN | RXEN
+#define UART_IRQ_RXA    (1 << 3)
+
+#define SPI_CFG         0x008
+#define SPI_CTRL        0x00C
+#define SPI_PR          0x010
+#define SPI_CTRL_GO     0x7     // SS | EN | RXEN
+#define SPI_CTRL_SS     0x1
+
+#define SSLV_STATUS     0x014
+#define SSLV_OVERRUN    0x20
+#define SSLV_UNDERRUN   0x40
+
+#define QSPI_CTRL       0x00C
+#define QSPI_PR         0x010
+#define QSPI_STATUS     0x014
+#define QSPI_CTRL_EN    0x1
+#define QSPI_CTRL_SS    0x2
+#define QSPI_X1         (0 << 8)
+#define QSPI_X4         (2 << 8)
+#define QSPI_READ       (1 << 10)
+#define QSPI_BUSY       0x1
+#define QSPI_TX_EMPTY   0x2
+
+#define FIFO_DEPTH      16
+
+// Pads
+#define PIN_UART_TX     9
+#define PIN_UART_RX     10
+#define PIN_SPI_EN      13
+#define PIN_UART_EN     14
+#define PIN_UART1_TX    17
+#define PIN_UART1_RX    18
+
+// LA mailbox: requests in la_oenb[7:0], response flags in la_data_out[127:120]
+#define LAM_PUSH        0x01
+#define LAM_POP         0x02
+#define LAM_PUSH_UART   0x04
+#define LAM_POP_UART    0x08
+#define LAM_PUSH_LEN(n) (((n) - 1) << 4)
+#define LAM_REQ_MASK    0xFF
+#define LAM_POP_COUNT(w)    (((w) >> 24) & 0xF)
+#define LAM_POP_ACK     (1u << 30)
+#define LAM_PUSH_ACK    (1u << 31)
+
+// CF_UART samples each bit SC (8) times, one sample per PR + 1 cycles
+#define UART_SC         8
+
+struct Options {
+    std::string test = "all";
+    unsigned bytes = 4096;
+    unsigned spi_pr = 4;
+    unsigned uart_pr = 1;
+    unsigned ser_half = 5;
+    uint64_t max_cycles = 0;
+    const char* vcd = nullptr;
+    const char* save = nullptr;
+    const char* restore = nullptr;
+};
+
+static void check(bool cond, const char* what) {
+    if (!cond)
+        throw std::runtime_error(what);
+}
+
+// Bring the project out of reset with both serial cores' pads enabled,
+// or pick up the checkpoint of that state
+static void boot(UserProjSim& sim, const Options& opt) {
+    if (opt.restore) {
+        sim.restore(opt.restore);
+        return;
+    }
+    sim.set_pin(PIN_UART_RX, 1);
+    sim.set_pin(PIN_SPI_EN, 1);
+    sim.set_pin(PIN_UART_EN, 1);
+    sim.reset();
+    if (opt.save)
+        sim.save(opt.save);
+}
+
+static void test_smoke(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+
+    sim.max_cycles = opt.max_cycles;
+    boot(sim, opt);
+
+    check(wb.read(VERSION_REG) == VERSION_VALUE, "VERSION mismatch");
+
+    for (uint32_t i = 0; i < 64; i++)
+        wb.write(BUF_BASE + 4 * i, 0xA5000000u ^ (i * 0x01010101u));
+    for (uint32_t i = 0; i < 64; i++)
+        check(wb.read(BUF_BASE + 4 * i) == (0xA5000000u ^ (i * 0x01010101u)),
+              "DMA buffer readback mismatch");
+
+    printf("smoke: ok, %llu cycles\n", (unsigned long long)sim.wb_cycles);
+}
+
+// Stream bytes through UART channel 0 into an echoing peer and check
+// that every byte comes back in order
+static uint64_t test_uart(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    unsigned sent = 0;
+    unsigned got = 0;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+
+    while (got < opt.bytes) {
+        unsigned room = FIFO_DEPTH - wb.read(UART_BASE + IP_TX_LEVEL);
+        while (room-- && sent < opt.bytes)
+            wb.write(UART_BASE + IP_TXDATA, (sent++) & 0xFF);
+
+        unsigned level = wb.read(UART_BASE + IP_RX_LEVEL);
+        while (level--) {
+            uint8_t b = wb.read(UART_BASE + IP_RXDATA) & 0xFF;
+            check(b == (got & 0xFF), "UART echo mismatch");
+            got++;
+        }
+    }
+    check(peer.framing_errors == 0, "UART framing error");
+
+    printf("uart: %u bytes, %llu cycles, %llu bus accesses\n", got,
+           (unsigned long long)sim.wb_cycles, (unsigned long long)wb.accesses);
+    return sim.wb_cycles;
+}
+
+// Loop bytes through UART channel 1 and its echoing peer, and check
+// that the RX interrupt shows up in UART_IRQ as channel 1 only
+static uint64_t test_uart1(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART1_TX, PIN_UART1_RX, (opt.uart_pr + 1) * UART_SC, true);
+    const unsigned n = 8;
+    uint32_t irq;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    sim.set_pin(PIN_UART1_RX, 1);
+    boot(sim, opt);
+
+    check(wb.read(UART_IRQ_REG) == 0, "UART_IRQ pending after reset");
+
+    wb.write(UART1_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART1_BASE + IP_RX_THRESH, n / 2);
+    wb.write(UART1_BASE + IP_IM, UART_IRQ_RXA);
+    wb.write(UART1_BASE + UART_CTRL, UART_CTRL_EN);
+    for (unsigned i = 0; i < n; i++)
+        wb.write(UART1_BASE + IP_TXDATA, 0xC0 + i);
+
+    for (unsigned t = 0; wb.read(UART1_BASE + IP_RX_LEVEL) < n; t++)
+        check(t < 100000, "UART channel 1 echo stalled");
+    sim.run(8);     // interrupt synchroniser
+
+    irq = wb.read(UART_IRQ_REG);
+    check((irq & 0xFFFF) == 0x2, "UART_IRQ pending vector is not channel 1");
+    check(((irq >> 16) & 0xF) == 1, "UART_IRQ lowest pending channel is not 1");
+    check(irq >> 31, "UART_IRQ any-pending bit clear");
+    check(sim.top->irq & 0x2, "irq[1] not raised for channel 1");
+
+    for (unsigned i = 0; i < n; i++)
+        check((wb.read(UART1_BASE + IP_RXDATA) & 0xFF) == 0xC0 + i, "UART channel 1 echo mismatch");
+    wb.write(UART1_BASE + IP_IC, UART_IRQ_RXA);
+    sim.run(8);
+    check(wb.read(UART_IRQ_REG) == 0, "UART_IRQ still pending after clear");
+    check(peer.framing_errors == 0, "UART channel 1 framing error");
+
+    printf("uart1: %u bytes, %llu cycles\n", n, (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Coalesce UART data register accesses with a threshold of 4: irq[2]
+// must stay low for three bytes, rise on the fourth and drop on the
+// acknowledge, for TX pushes and again for RX pops
+static uint64_t test_irqc(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    const unsigned thresh = 4;
+    uint32_t cause;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+    wb.write(IRQC_THRESH, (thresh << 8) | 0x010001);
+    wb.write(IRQC_CTRL, IRQC_SRC_UART);
+
+    for (unsigned pass = 0; pass < 2; pass++) {
+        for (unsigned i = 0; i < thresh; i++) {
+            if (i == thresh - 1) {
+                check(((wb.read(IRQC_COUNT) >> 8) & 0xFF) == thresh - 1, "coalescer count wrong");
+                cause = wb.read(IRQC_CAUSE);
+                check((cause & IRQC_SRC_UART) && !(cause & (IRQC_SRC_UART << 8)),
+                      "coalescer threshold reached early");
+                check(!(sim.top->irq & 0x4), "irq[2] raised below the threshold");
+            }
+            if (pass == 0) {
+                wb.write(UART_BASE + IP_TXDATA, 0x30 + i);
+            } else {
+                for (unsigned t = 0; wb.read(UART_BASE + IP_RX_LEVEL) == 0; t++)
+                    check(t < 100000, "UART echo stalled");
+                check((wb.read(UART_BASE + IP_RXDATA) & 0xFF) == 0x30 + i, "UART echo mismatch");
+            }
+        }
+        sim.run(2);
+        check(wb.read(IRQC_CAUSE) & (IRQC_SRC_UART << 8), "coalescer threshold not reached");
+        check(sim.top->irq & 0x4, "irq[2] not raised at the threshold");
+        check((wb.read(IRQC_COUNT) & 0xFF00FF) == 0, "disabled coalescer source counted");
+
+        wb.write(IRQC_CAUSE, IRQC_SRC_UART);
+        sim.run(2);
+        check(!(sim.top->irq & 0x4), "irq[2] still high after the acknowledge");
+    }
+
+    printf("irqc: %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Echo bytes through UART channel 0 on the fractional baud generator,
+// which thins the core clock the UART's register interface also runs
+// on. FRAC + 1 = 2^27 / 24 rounded down gives a 24-cycle bit from an
+// uneven pulse pattern. Auto-baud then measures a 'U' at 40 cycles a
+// bit and the echo is repeated at the new rate.
+static uint64_t test_baud(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, 24, true);
+    const unsigned n = 64;
+    unsigned sent = 0;
+    unsigned got = 0;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    auto echo = [&](uint8_t seed) {
+        sent = got = 0;
+        while (got < n) {
+            unsigned room = FIFO_DEPTH - wb.read(UART_BASE + IP_TX_LEVEL);
+            while (room-- && sent < n)
+                wb.write(UART_BASE + IP_TXDATA, (uint8_t)(seed + 3 * sent++));
+
+            unsigned level = wb.read(UART_BASE + IP_RX_LEVEL);
+            check(level <= n - got, "UART RX level counts bytes never sent");
+            while (level--) {
+                uint8_t b = wb.read(UART_BASE + IP_RXDATA) & 0xFF;
+                check(b == (uint8_t)(seed + 3 * got), "fractional baud echo mismatch");
+                got++;
+            }
+        }
+        check(wb.read(UART_BASE + IP_TX_LEVEL) == 0, "UART TX FIFO not drained");
+    };
+
+    wb.write(BAUD_FRAC, (1u << 27) / 24 - 1);
+    wb.write(BAUD_CTRL, BAUD_FRAC_EN);
+    wb.write(UART_BASE + UART_PR, 0);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+    echo(0x11);
+    check(peer.framing_errors == 0, "UART framing error at the fractional rate");
+
+    // Auto-baud with the peer at 40 cycles a bit
+    peer.set_bit_cycles(40);
+    wb.write(BAUD_CTRL, BAUD_FRAC_EN | BAUD_AUTO);
+    check(wb.read(BAUD_STATUS) & BAUD_BUSY, "auto-baud not armed");
+    peer.send(0x55);
+    for (unsigned t = 0; !(wb.read(BAUD_STATUS) & BAUD_DONE); t++)
+        check(t < 100000, "auto-baud did not finish");
+    const uint32_t meas = wb.read(BAUD_MEAS);
+    check(meas >= 8 * 40 - 2 && meas <= 8 * 40 + 2, "auto-baud measured the wrong period");
+    check(wb.read(BAUD_CTRL) & BAUD_FRAC_EN, "auto-baud left FRAC_EN off");
+
+    // The 'U' arrived at the old rate; whatever it left must drain
+    sim.run(40 * 10 * 2);
+    for (unsigned t = 0; wb.read(UART_BASE + IP_RX_LEVEL); t++) {
+        check(t < FIFO_DEPTH, "UART RX FIFO does not drain on the thinned clock");
+        wb.read(UART_BASE + IP_RXDATA);
+    }
+    peer.framing_errors = 0;
+    echo(0x80);
+    check(peer.framing_errors == 0, "UART framing error after auto-baud");
+
+    printf("baud: %u bytes at each rate, %llu cycles\n", n, (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Clock bytes through the SPI master; the slave returns each byte one
+// transfer later
+static uint64_t test_spi(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    SpiSlave slave;
+    unsigned sent = 0;
+    unsigned got = 0;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&slave);
+    boot(sim, opt);
+
+    wb.write(SPI_BASE + SPI_CFG, 0);    // mode 0
+    wb.write(SPI_BASE + SPI_PR, opt.spi_pr);
+    wb.write(SPI_BASE + SPI_CTRL, SPI_CTRL_GO);
+
+    while (got < opt.bytes) {
+        // Bytes in flight never exceed what the RX FIFO can hold
+        unsigned room = FIFO_DEPTH - (sent - got);
+        while (room-- && sent < opt.bytes)
+            wb.write(SPI_BASE + IP_TXDATA, (sent++ * 7) & 0xFF);
+
+        unsigned level = wb.read(SPI_BASE + IP_RX_LEVEL);
+        while (level--) {
+            uint8_t b = wb.read(SPI_BASE + IP_RXDATA) & 0xFF;
+            check(b == (got ? ((got - 1) * 7) & 0xFF : 0xFF), "SPI readback mismatch");
+            got++;
+        }
+    }
+    wb.write(SPI_BASE + SPI_CTRL, 0);
+
+    check(slave.received.size() == opt.bytes, "SPI slave byte count mismatch");
+    for (unsigned i = 0; i < opt.bytes; i++)
+        check(slave.received[i] == ((i * 7) & 0xFF), "SPI slave data mismatch");
+
+    printf("spi: %u bytes, %llu cycles, %llu bus accesses\n", got,
+           (unsigned long long)sim.wb_cycles, (unsigned long long)wb.accesses);
+    return sim.wb_cycles;
+}
+
+// Full-duplex SPI <-> UART bridge with no Wishbone traffic once it is
+// enabled. Bytes from the UART peer go out on MOSI; the SPI slave
+// returns each one a transfer later on MISO, and the bridge sends that
+// back out of the UART.
+static uint64_t test_bridge(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    SpiSlave slave;
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, false);
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&slave);
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    wb.write(SPI_BASE + SPI_CFG, 0);    // mode 0
+    wb.write(SPI_BASE + SPI_PR, opt.spi_pr);
+    wb.write(SPI_BASE + SPI_CTRL, SPI_CTRL_GO);
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+    wb.write(CONTROL_REG, CONTROL_BRIDGE);
+
+    const uint64_t start = sim.wb_cycles;
+    // Each byte crosses the UART twice and the SPI once; allow twice that
+    const uint64_t limit = (uint64_t)opt.bytes * opt.ser_half / 5 *
+                           (40 * (opt.uart_pr + 1) * UART_SC + 32 * (opt.spi_pr + 1)) + 100000;
+
+    for (unsigned i = 0; i < opt.bytes; i++)
+        peer.send((i * 13 + 1) & 0xFF);
+
+    while (peer.received.size() < opt.bytes) {
+        sim.tick();
+        check(!sim.top->wbs_ack_o, "Wishbone activity while bridging");
+        check(sim.wb_cycles - start < limit, "bridge stalled");
+    }
+    check(peer.framing_errors == 0, "UART framing error");
+
+    check(slave.received.size() >= opt.bytes, "UART -> SPI byte count mismatch");
+    for (unsigned i = 0; i < opt.bytes; i++)
+        check(slave.received[i] == ((i * 13 + 1) & 0xFF), "UART -> SPI data mismatch");
+    for (unsigned i = 0; i < opt.bytes; i++)
+        check(peer.received[i] == (i ? ((i - 1) * 13 + 1) & 0xFF : 0xFF),
+              "SPI -> UART data mismatch");
+
+    printf("bridge: %u bytes each way, %llu cycles\n", opt.bytes,
+           (unsigned long long)(sim.wb_cycles - start));
+    return sim.wb_cycles;
+}
+
+// Quad write and quad read against QspiFlash, which also checks that the
+// project drives and releases IO0-IO3 at the right times
+static uint64_t test_qspi(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    QspiFlash flash(256);
+    const unsigned n = 12;  // opcode + dummy + data fit in the TX FIFO
+    uint8_t data[n];
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&flash);
+    boot(sim, opt);
+
+    auto wait_idle = [&]() {
+        for (unsigned t = 0;; t++) {
+            uint32_t st = wb.read(QSPI_BASE + QSPI_STATUS);
+            if ((st & QSPI_TX_EMPTY) && !(st & QSPI_BUSY))
+                return;
+            check(t < 100000, "QSPI transfer stalled");
+        }
+    };
+
+    for (unsigned i = 0; i < n; i++)
+        data[i] = (uint8_t)(0x5A ^ (i * 0x25));
+
+    // Reads sample a registered pad, so PR must be at least 2
+    wb.write(QSPI_BASE + QSPI_PR, opt.spi_pr < 2 ? 2 : opt.spi_pr);
+    wb.write(QSPI_BASE + QSPI_CTRL, QSPI_CTRL_EN | QSPI_CTRL_SS);
+    wb.write(QSPI_BASE + IP_TXDATA, QSPI_X1 | QspiFlash::CMD_QUAD_WRITE);
+    for (unsigned i = 0; i < n; i++)
+        wb.write(QSPI_BASE + IP_TXDATA, QSPI_X4 | data[i]);
+    wait_idle();
+    wb.write(QSPI_BASE + QSPI_CTRL, QSPI_CTRL_EN);
+
+    // One x4 READ entry covers the two dummy clocks and is dropped
+    wb.write(QSPI_BASE + QSPI_CTRL, QSPI_CTRL_EN | QSPI_CTRL_SS);
+    wb.write(QSPI_BASE + IP_TXDATA, QSPI_X1 | QspiFlash::CMD_QUAD_READ);
+    for (unsigned i = 0; i <= n; i++)
+        wb.write(QSPI_BASE + IP_TXDATA, QSPI_X4 | QSPI_READ);
+    wait_idle();
+    wb.write(QSPI_BASE + QSPI_CTRL, QSPI_CTRL_EN);
+    sim.run(8);
+    wb.write(QSPI_BASE + QSPI_CTRL, 0);
+
+    check(wb.read(QSPI_BASE + IP_RX_LEVEL) == n + 1, "QSPI RX byte count mismatch");
+    wb.read(QSPI_BASE + IP_RXDATA);
+    for (unsigned i = 0; i < n; i++) {
+        check(flash.mem[i] == data[i], "QSPI write data mismatch");
+        check((wb.read(QSPI_BASE + IP_RXDATA) & 0xFF) == data[i], "QSPI read data mismatch");
+    }
+    check(flash.bad_opcodes == 0, "QSPI opcode mismatch");
+    check(flash.direction_errors == 0, "QSPI lane not driven while clocked out");
+    check(flash.contention == 0, "QSPI lane driven against the memory");
+
+    printf("qspi: %u bytes each way, %llu cycles\n", n, (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// SPI slave mode: a host model on the SPI pads clocks five bytes in
+// while the slave answers with four queued replies, so the fifth goes
+// out as 0xFF and counts as one underrun
+static uint64_t test_sslv(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    // Each SCLK phase must last 4 bus clocks (40 time units); one more
+    // covers the synchroniser
+    SpiHost host((40 + 2 * opt.ser_half - 1) / (2 * opt.ser_half) + 1);
+    static const uint8_t reply[4] = {0xA5, 0x3C, 0x81, 0x7E};
+    static const uint8_t data[5] = {0x5A, 0xC3, 0x0F, 0xF0, 0x99};
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&host);
+    boot(sim, opt);
+
+    wb.write(CONTROL_REG, CONTROL_SPI_SLAVE);
+    for (unsigned i = 0; i < 4; i++)
+        wb.write(SSLV_BASE + IP_TXDATA, reply[i]);
+    wb.write(PERF_CTRL, PERF_SNAPSHOT);     // start a clean interval
+
+    for (unsigned i = 0; i < 5; i++)
+        host.send(data[i]);
+    for (unsigned t = 0; wb.read(SSLV_BASE + IP_RX_LEVEL) < 5; t++)
+        check(t < 100000, "SPI slave receive stalled");
+    for (unsigned i = 0; i < 5; i++)
+        check((wb.read(SSLV_BASE + IP_RXDATA) & 0xFF) == data[i], "SPI slave RX data mismatch");
+
+    for (unsigned t = 0; !host.idle(); t++) {
+        check(t < 100000, "SPI host did not deselect");
+        sim.tick();
+    }
+    check(host.received.size() == 5, "SPI host byte count mismatch");
+    for (unsigned i = 0; i < 4; i++)
+        check(host.received[i] == reply[i], "SPI slave TX data mismatch");
+    check(host.received[4] == 0xFF, "SPI slave sent data from an empty TX FIFO");
+
+    check((wb.read(SSLV_BASE + SSLV_STATUS) & (SSLV_OVERRUN | SSLV_UNDERRUN)) == SSLV_UNDERRUN,
+          "SPI slave STATUS should show an underrun only");
+    wb.write(PERF_CTRL, PERF_SNAPSHOT);
+    check(wb.read(PERF_SSLV_UNDERRUN) == 1, "SPI slave underrun count wrong");
+    check(wb.read(PERF_SSLV_OVERRUN) == 0, "SPI slave overrun counted");
+    wb.write(CONTROL_REG, 0);
+
+    printf("sslv: 5 bytes each way, %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Loop "123456789" through UART channel 0 and an echoing peer under
+// three catalogue CRCs, with a channel 1 push and pop after each pass.
+// Both channel 0 CRCs must give the catalogue check value.
+static uint64_t test_crc(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    const uint32_t uart = CRC_EN(CRC_CH_UART_TX) | CRC_EN(CRC_CH_UART_RX) |
+                          CRC_RST(CRC_CH_UART_TX) | CRC_RST(CRC_CH_UART_RX);
+    static const char check_str[] = "123456789";
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    sim.set_pin(PIN_UART1_RX, 1);
+    boot(sim, opt);
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+
+    auto run = [&](uint32_t ctrl, uint32_t expect, const char* name) {
+        wb.write(CRC_CTRL, ctrl | uart);
+        for (unsigned i = 0; i < 9; i++)
+            wb.write(UART_BASE + IP_TXDATA, (uint8_t)check_str[i]);
+        for (unsigned t = 0; wb.read(UART_BASE + IP_RX_LEVEL) < 9; t++)
+            check(t < 100000, "UART echo stalled");
+        for (unsigned i = 0; i < 9; i++)
+            check((wb.read(UART_BASE + IP_RXDATA) & 0xFF) == (uint8_t)check_str[i],
+                  "UART echo mismatch");
+
+        // Channel 1 traffic stays out of the channel 0 CRCs
+        wb.write(UART1_BASE + IP_TXDATA, 0x5A);
+        wb.read(UART1_BASE + IP_RXDATA);
+
+        if (wb.read(CRC_VALUE(CRC_CH_UART_TX)) != expect ||
+            wb.read(CRC_VALUE(CRC_CH_UART_RX)) != expect)
+            throw std::runtime_error(std::string(name) + " check value mismatch");
+    };
+
+    // CRC-32 from the reset defaults
+    run(CRC_SIZE32 | CRC_REFIN | CRC_REFOUT, 0xCBF43926, "CRC-32");
+
+    wb.write(CRC_POLY, 0x1021);
+    wb.write(CRC_INIT, 0xFFFF);
+    wb.write(CRC_XOROUT, 0);
+    run(0, 0x29B1, "CRC-16/CCITT-FALSE");
+
+    wb.write(CRC_POLY, 0x8005);
+    wb.write(CRC_INIT, 0);
+    run(CRC_REFIN | CRC_REFOUT, 0xBB3D, "CRC-16/ARC");
+    check(peer.framing_errors == 0, "UART framing error");
+
+    printf("crc: 3 CRCs, %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Send one frame full of SLIP specials and zeros through the framer,
+// UART channel 0 and an echoing peer, first SLIP and then COBS, and
+// check the decoded frame. Then fill the COBS code queue with EN clear
+// and check TX_FULL, TX_OVERFLOW and its clear.
+static uint64_t test_framer(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    static const uint8_t frame[12] = {0xC0, 0x01, 0xDB, 0x00, 0x00, 0xDC, 0xDD, 0x7E,
+                                      0x00, 0xC0, 0xDB, 0x00};
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+
+    auto loop = [&](bool cobs) {
+        const char* what = cobs ? "COBS frame mismatch" : "SLIP frame mismatch";
+
+        // 12 bytes encode to far less than the 256-entry TX FIFO
+        wb.write(FRM_CTRL, FRM_EN | (cobs ? FRM_COBS : 0));
+        for (unsigned i = 0; i < 12; i++)
+            wb.write(FRM_TXDATA, frame[i] | (i == 11 ? FRM_TX_END : 0));
+
+        for (unsigned t = 0; !(wb.read(FRM_STATUS) & FRM_FRAME); t++)
+            check(t < 100000, "framer did not receive the frame");
+        const uint32_t info = wb.read(FRM_RXLEN);
+        check(info & FRM_RXLEN_VALID, "framer RXLEN not valid with a frame waiting");
+        check(!(info & FRM_RXLEN_ERROR), "framer marked a good frame as corrupt");
+        check((info & 0xFFFF) == 12, what);
+        for (unsigned i = 0; i < 12; i++)
+            check((wb.read(FRM_RXDATA) & 0xFF) == frame[i], what);
+
+        for (unsigned t = 0; !(wb.read(FRM_STATUS) & FRM_TX_IDLE); t++)
+            check(t < 100000, "framer TX did not go idle");
+        wb.write(FRM_CTRL, 0);
+    };
+
+    loop(false);
+    loop(true);
+    check(peer.framing_errors == 0, "UART framing error");
+
+    // With EN clear nothing drains. In COBS mode each zero takes a code
+    // entry and the code queue fills after 15, so the 16th is dropped.
+    wb.write(FRM_CTRL, FRM_COBS);
+    for (unsigned i = 0; i < 15; i++)
+        wb.write(FRM_TXDATA, 0x00);
+    check((wb.read(FRM_STATUS) & (FRM_TX_FULL | FRM_TX_OVERFLOW)) == FRM_TX_FULL,
+          "framer TX not full after 15 COBS zeros");
+    wb.write(FRM_TXDATA, 0x00);
+    check(wb.read(FRM_STATUS) & FRM_TX_OVERFLOW, "framer TX overflow not flagged");
+    wb.write(FRM_STATUS, FRM_TX_OVERFLOW);
+    check(!(wb.read(FRM_STATUS) & FRM_TX_OVERFLOW), "framer TX overflow not cleared");
+
+    printf("framer: 2 frames of 12 bytes, %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Follow UART channel 0's FIFO levels through SNAPSHOT with the status
+// poller on. Each read returns the previous round, so wait until the
+// wanted value shows up.
+static uint64_t test_snapshot(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    uint32_t snap;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    auto wait_snap = [&](bool (*cond)(uint32_t), const char* what) {
+        for (unsigned t = 0; !cond(snap = wb.read(SNAPSHOT_REG)); t++)
+            check(t < 10000, what);
+    };
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+    check(!(wb.read(SNAPSHOT_REG) & SNAP_VALID), "SNAPSHOT valid with polling off");
+
+    wb.write(CONTROL_REG, CONTROL_STATUS_POLL);
+    wait_snap([](uint32_t s) { return (s & SNAP_VALID) != 0; },
+              "SNAPSHOT never became valid");
+    check(SNAP_UART_RX_LEVEL(snap) == 0 && SNAP_UART_TX_LEVEL(snap) == 0,
+          "SNAPSHOT shows UART data after reset");
+
+    // Three bytes come back from the peer
+    wb.write(UART_BASE + IP_TXDATA, 0xA5);
+    wb.write(UART_BASE + IP_TXDATA, 0x5A);
+    wb.write(UART_BASE + IP_TXDATA, 0x3C);
+    wait_snap([](uint32_t s) { return SNAP_UART_RX_LEVEL(s) == 3; },
+              "SNAPSHOT UART RX level never reached 3");
+    check(SNAP_UART_TX_LEVEL(snap) == 0, "SNAPSHOT UART TX level not 0 after the echo");
+    check(wb.read(UART_BASE + IP_RX_LEVEL) == 3, "UART RX level disagrees with SNAPSHOT");
+    check(!(snap & SNAP_UART_ERRORS), "SNAPSHOT shows UART errors");
+    check(!(snap & SNAP_IRQ_UART0), "SNAPSHOT shows a masked UART interrupt");
+
+    for (unsigned i = 0; i < 3; i++)
+        wb.read(UART_BASE + IP_RXDATA);
+    wait_snap([](uint32_t s) { return SNAP_UART_RX_LEVEL(s) == 0; },
+              "SNAPSHOT UART RX level did not drop back to 0");
+
+    wb.write(CONTROL_REG, 0);
+    wait_snap([](uint32_t s) { return !(s & SNAP_VALID); },
+              "SNAPSHOT still valid with polling off");
+    check(peer.framing_errors == 0, "UART framing error");
+
+    printf("snapshot: %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Idle clock gating on the SPI and UART cores with the shortest idle
+// time, traffic on UART channel 0. Both clocks must stop when idle, register
+// accesses must wake them without a retry, an 8-byte echo must arrive
+// whole before the UART clock stops, status polling must still let
+// them stop, and turning gating off must restart them.
+static uint64_t test_clkgate(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    static const uint8_t data[8] = {0x00, 0xFF, 0x55, 0xAA, 0x0F, 0xF0, 0x81, 0x7E};
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    sim.set_pin(PIN_UART1_RX, 1);   // a low RX line keeps channel 1's clock on
+    boot(sim, opt);
+
+    auto wait_clk = [&](bool off, const char* what) {
+        const uint32_t want = off ? STATUS_CLK_OFF : 0;
+        for (unsigned t = 0; (wb.read(STATUS_REG) & STATUS_CLK_OFF) != want; t++)
+            check(t < 10000, what);
+    };
+
+    // SPI enabled but deselected, so CSB does not hold its clock on
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+    wb.write(SPI_BASE + SPI_CFG, 0);
+    wb.write(SPI_BASE + SPI_PR, opt.spi_pr);
+    wb.write(SPI_BASE + SPI_CTRL, SPI_CTRL_GO & ~SPI_CTRL_SS);
+    check(!(wb.read(STATUS_REG) & STATUS_CLK_OFF), "core clock off with gating disabled");
+
+    wb.write(CONTROL_REG, CONTROL_CLK_IDLE(0));
+    wb.write(CONTROL_REG, CONTROL_CLK_IDLE(0) | CONTROL_CLK_GATE);
+    wait_clk(true, "core clocks did not stop");
+
+    check(wb.read(UART_BASE + UART_PR) == opt.uart_pr, "UART register read while gated");
+    check(wb.read(SPI_BASE + SPI_PR) == opt.spi_pr, "SPI register read while gated");
+
+    // The UART clock holds for whole frames, so all 8 bytes are back
+    // before it stops
+    for (unsigned i = 0; i < 8; i++)
+        wb.write(UART_BASE + IP_TXDATA, data[i]);
+    wait_clk(true, "core clocks did not stop after the echo");
+    check(wb.read(UART_BASE + IP_RX_LEVEL) == 8, "UART clock stopped mid-stream");
+    for (unsigned i = 0; i < 8; i++)
+        check((wb.read(UART_BASE + IP_RXDATA) & 0xFF) == data[i], "gated UART echo mismatch");
+    check(peer.framing_errors == 0, "UART framing error while gated");
+    wait_clk(true, "core clocks did not stop after the reads");
+
+    // The poller only runs on SNAPSHOT reads, so the clocks still stop
+    wb.write(CONTROL_REG, CONTROL_CLK_IDLE(0) | CONTROL_CLK_GATE | CONTROL_STATUS_POLL);
+    wait_clk(true, "status polling holds the core clocks on");
+    for (unsigned t = 0; !(wb.read(SNAPSHOT_REG) & SNAP_VALID); t++)
+        check(t < 100, "SNAPSHOT never became valid while gated");
+    wait_clk(true, "core clocks did not stop after a poll round");
+
+    wb.write(CONTROL_REG, CONTROL_CLK_IDLE(0));
+    wait_clk(false, "core clocks did not restart with gating off");
+
+    printf("clkgate: %llu cycles\n", (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+// Push 21 bytes into UART channel 0 through the LA mailbox, a full
+// 16-byte push and a 5-byte one queued behind it, and pop the echo back
+// the same way. No Wishbone access may complete while it runs.
+static uint64_t test_la(const Options& opt) {
+    UserProjSim sim(5, opt.ser_half, opt.vcd);
+    WbBfm wb(sim);
+    UartPeer peer(PIN_UART_TX, PIN_UART_RX, (opt.uart_pr + 1) * UART_SC, true);
+    const unsigned n = 21;
+    uint8_t data[n];
+    uint8_t rx[n + 15];
+    unsigned got = 0;
+    uint32_t req = 0xFFFFFFFF & ~LAM_REQ_MASK;
+
+    sim.max_cycles = opt.max_cycles;
+    sim.add_model(&peer);
+    boot(sim, opt);
+
+    auto wait_ack = [&](uint32_t bit, uint32_t ack, const char* what) {
+        for (unsigned t = 0; !(sim.top->la_data_out[3] & ack) != !(req & bit); t++) {
+            check(t < 100000, what);
+            sim.tick();
+            check(!sim.top->wbs_ack_o, "Wishbone activity during an LA mailbox transfer");
+        }
+    };
+
+    auto push = [&](const uint8_t* buf, unsigned len) {
+        wait_ack(LAM_PUSH, LAM_PUSH_ACK, "LA mailbox push not taken");
+        for (unsigned i = 0; i < 4; i++)
+            sim.top->la_data_in[i] = 0;
+        for (unsigned i = 0; i < len; i++)
+            sim.top->la_data_in[i >> 2] |= (uint32_t)buf[i] << (8 * (i & 3));
+        req &= ~(LAM_PUSH_UART | LAM_PUSH_LEN(16));
+        req ^= LAM_PUSH;
+        req |= LAM_PUSH_UART | LAM_PUSH_LEN(len);
+        sim.top->la_oenb[0] = req;
+    };
+
+    auto pop = [&](uint8_t* buf) {
+        req ^= LAM_POP;
+        req |= LAM_POP_UART;
+        sim.top->la_oenb[0] = req;
+        wait_ack(LAM_POP, LAM_POP_ACK, "LA mailbox pop not answered");
+        const unsigned count = LAM_POP_COUNT(sim.top->la_data_out[3]);
+        for (unsigned i = 0; i < count; i++)
+            buf[i] = (uint8_t)(sim.top->la_data_out[i >> 2] >> (8 * (i & 3)));
+        return count;
+    };
+
+    for (unsigned i = 0; i < n; i++)
+        data[i] = (uint8_t)(0x30 + 7 * i);
+
+    wb.write(UART_BASE + UART_PR, opt.uart_pr);
+    wb.write(UART_BASE + UART_CTRL, UART_CTRL_EN);
+
+    // Clear the request toggles; the acks follow them while disabled
+    sim.top->la_oenb[0] = req;
+    sim.run(4);
+    wb.write(CONTROL_REG, CONTROL_LA_MAILBOX);
+    sim.run(2);     // let the last Wishbone ack clear
+
+    push(data, 16);
+    push(data + 16, n - 16);
+    for (unsigned t = 0; got < n; t++) {
+        check(t < 100000, "LA mailbox echo stalled");
+        got += pop(rx + got);
+    }
+    check(got == n, "LA mailbox popped bytes never pushed");
+    for (unsigned i = 0; i < n; i++)
+        check(rx[i] == data[i], "LA mailbox echo mismatch");
+    check(pop(rx) == 0, "LA mailbox left bytes behind");
+    check(peer.framing_errors == 0, "UART framing error");
+
+    wb.write(CONTROL_REG, 0);
+
+    printf("la: %u bytes each way, %llu cycles\n", n, (unsigned long long)sim.wb_cycles);
+    return sim.wb_cycles;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--test smoke|spi|uart|uart1|irqc|baud|bridge|qspi|sslv|crc|\n"
+            "                 framer|snapshot|clkgate|la|all]\n"
+            "          [--bytes N] [--spi-pr N] [--uart-pr N] [--ser-half N]\n"
+            "          [--max-cycles N] [--vcd FILE]\n"
+            "          [--save FILE | --restore FILE]\n",
+            prog);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+
+    Verilated::commandArgs(argc, argv);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (arg[0] == '+')
+            continue;   // Verilator plusargs
+        if (i + 1 >= argc)
+            usage(argv[0]);
+        const char* val = argv[++i];
+        if (!strcmp(arg, "--test"))
+            opt.test = val;
+        else if (!strcmp(arg, "--bytes"))
+            opt.bytes = strtoul(val, nullptr, 0);
+        else if (!strcmp(arg, "--spi-pr"))
+            opt.spi_pr = strtoul(val, nullptr, 0);
+        else if (!strcmp(arg, "--uart-pr"))
+            opt.uart_pr = strtoul(val, nullptr, 0);
+        else if (!strcmp(arg, "--ser-half"))
+            opt.ser_half = strtoul(val, nullptr, 0);
+        else if (!strcmp(arg, "--max-cycles"))
+            opt.max_cycles = strtoull(val, nullptr, 0);
+        else if (!strcmp(arg, "--vcd"))
+            opt.vcd = val;
+        else if (!strcmp(arg, "--save"))
+            opt.save = val;
+        else if (!strcmp(arg, "--restore"))
+            opt.restore = val;
+        else
+            usage(argv[0]);
+    }
+    if (opt.ser_half == 0 || (opt.save && opt.restore))
+        usage(argv[0]);
+
+    const bool all = (opt.test == "all");
+    if (!all && opt.test != "smoke" && opt.test != "spi" && opt.test != "uart" &&
+        opt.test != "uart1" && opt.test != "irqc" && opt.test != "baud" &&
+        opt.test != "bridge" && opt.test != "qspi" && opt.test != "sslv" &&
+        opt.test != "crc" && opt.test != "framer" &&
+        opt.test != "snapshot" && opt.test != "clkgate" &&
+        opt.test != "la")
+        usage(argv[0]);
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t cycles = 0;
+
+        if (all || opt.test == "smoke")
+            test_smoke(opt);
+        if (all || opt.test == "spi")
+            cycles += test_spi(opt);
+        if (all || opt.test == "uart")
+            cycles += test_uart(opt);
+        if (all || opt.test == "uart1")
+            cycles += test_uart1(opt);
+        if (all || opt.test == "irqc")
+            cycles += test_irqc(opt);
+        if (all || opt.test == "baud")
+            cycles += test_baud(opt);
+        if (all || opt.test == "bridge")
+            cycles += test_bridge(opt);
+        if (all || opt.test == "qspi")
+            cycles += test_qspi(opt);
+        if (all || opt.test == "sslv")
+            cycles += test_sslv(opt);
+        if (all || opt.test == "crc")
+            cycles += test_crc(opt);
+        if (all || opt.test == "framer")
+            cycles += test_framer(opt);
+        if (all || opt.test == "snapshot")
+            cycles += test_snapshot(opt);
+        if (all || opt.test == "clkgate")
+            cycles += test_clkgate(opt);
+        if (all || opt.test == "la")
+            cycles += test_la(opt);
+
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("PASS: %.2f s", secs);
+        if (cycles && secs > 0)
+            printf(", %.2f Mcycles/s", cycles / secs / 1e6);
+        printf("\n");
+    } catch (const std::exception& e) {
+        printf("FAIL: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
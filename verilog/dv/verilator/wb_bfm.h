@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+// Wishbone master driving the wbs_* port the way the management core
+// does: one classic cycle at a time, STB dropped as soon as ACK is seen.
+
+#ifndef WB_BFM_H
+#define WB_BFM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+#include "user_proj_sim.h"
+
+#define USER_WB_BASE 0x30000000u
+
+class WbBfm {
+public:
+    explicit WbBfm(UserProjSim& sim, unsigned timeout = 1000)
+        : sim_(sim), timeout_(timeout) {}
+
+    uint32_t read(uint32_t offset) { return xfer(false, offset, 0); }
+    void write(uint32_t offset, uint32_t data) { xfer(true, offset, data); }
+
+    uint64_t accesses = 0;
+
+private:
+    uint32_t xfer(bool we, uint32_t offset, uint32_t data) {
+        Vuser_proj_example* top = sim_.top.get();
+        unsigned n = 0;
+
+        top->wbs_cyc_i = 1;
+        top->wbs_stb_i = 1;
+        top->wbs_we_i = we;
+        top->wbs_sel_i = 0xF;
+        top->wbs_adr_i = USER_WB_BASE | offset;
+        top->wbs_dat_i = data;
+
+        do {
+            sim_.tick();
+            if (++n > timeout_) {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "no ACK for %s at 0x%04x",
+                         we ? "write" : "read", offset);
+                throw std::runtime_error(msg);
+            }
+        } while (!top->wbs_ack_o);
+
+        data = top->wbs_dat_o;
+        top->wbs_cyc_i = 0;
+        top->wbs_stb_i = 0;
+        top->wbs_we_i = 0;
+        accesses++;
+        return data;
+    }
+
+    UserProjSim& sim_;
+    unsigned timeout_;
+};
+
+#endif // WB_BFM_H
@@ -0,0 +1,204 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * crc_engine
+ *
+ * Four running CRCs over the bytes seen on the local bus:
+ * channel 0 SPI TX, 1 SPI RX, 2 UART TX, 3 UART RX. A byte is
+ * taken from every completed TXDATA write and RXDATA read, so
+ * firmware, DMA and bridge traffic are all covered; at most one
+ * byte arrives per cycle and each is folded in that cycle.
+ *
+ * Polynomial, init, reflection and final XOR are shared by all
+ * channels and follow the usual CRC catalogue parameters
+ * (e.g. CRC-32: POLY 0x04C11DB7, INIT and XOROUT 0xFFFFFFFF,
+ * REFIN and REFOUT set).
+ *
+ * Registers (offsets from the CRC block base):
+ * - 0x00 CRC_CTRL   : [0] SIZE (0: CRC-16, 1: CRC-32),
+ *                     [1] REFIN, [2] REFOUT,
+ *                     [7:4] channel enable,
+ *                     [11:8] reset channel to INIT (write 1)
+ * - 0x04 CRC_POLY   : polynomial, [15:0] for CRC-16
+ * - 0x08 CRC_INIT   : initial value
+ * - 0x0C CRC_XOROUT : final XOR
+ * - 0x10 + 4*i      : CRC_VALUE of channel i (read-only, after
+ *                     REFOUT and XOROUT)
+ *
+ *-------------------------------------------------------------
+ */
+
+module crc_engine (
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [4:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Snooped bytes, one-hot channel strobe
+    input [3:0] snoop_valid,
+    input [7:0] snoop_data
+);
+
+    // Register addresses
+    localparam CRC_CTRL   = 5'h00;
+    localparam CRC_POLY   = 5'h04;
+    localparam CRC_INIT   = 5'h08;
+    localparam CRC_XOROUT = 5'h0C;
+    localparam CRC_VALUE  = 5'h10;  // CRC_VALUE + 4*i: channel i
+
+    reg size32;
+    reg refin;
+    reg refout;
+    reg [3:0] chan_en;
+    reg [31:0] poly;
+    reg [31:0] init;
+    reg [31:0] xorout;
+    reg [127:0] state;
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire [3:0] chan_rst = (wb_cycle && wb_we && wb_addr == CRC_CTRL) ? wb_data_in[11:8] : 4'h0;
+    wire [31:0] width_mask = size32 ? 32'hFFFFFFFF : 32'h0000FFFF;
+
+    // One byte through the shift register, MSB first
+    function [31:0] crc_byte;
+        input [31:0] crc;
+        input [7:0] data;
+        input [31:0] p;
+        input wide;
+        integer b;
+        reg fb;
+        begin
+            crc_byte = crc;
+            for (b = 7; b >= 0; b = b - 1) begin
+                fb = (wide ? crc_byte[31] : crc_byte[15]) ^ data[b];
+                crc_byte = {crc_byte[30:0], 1'b0} ^ (fb ? p : 32'h0);
+            end
+            if (!wide)
+                crc_byte = crc_byte & 32'h0000FFFF;
+        end
+    endfunction
+
+    function [31:0] reflect;
+        input [31:0] v;
+        input wide;
+        integer b;
+        begin
+            reflect = 32'h0;
+            for (b = 0; b < 32; b = b + 1)
+                reflect[b] = v[31 - b];
+            if (!wide)
+                reflect = {16'h0, reflect[31:16]};
+        end
+    endfunction
+
+    wire [7:0] data_in;
+    genvar gb;
+    generate
+        for (gb = 0; gb < 8; gb = gb + 1) begin : g_refin
+            assign data_in[gb] = refin ? snoop_data[7 - gb] : snoop_data[gb];
+        end
+    endgenerate
+
+    // The shared byte only ever reaches one channel, so a single
+    // update network feeds whichever one is strobed
+    reg [31:0] cur;
+    integer c;
+
+    always @(*) begin
+        cur = 32'h0;
+        for (c = 0; c < 4; c = c + 1)
+            if (snoop_valid[c])
+                cur = state[32*c +: 32];
+    end
+
+    wire [31:0] next = crc_byte(cur, data_in, poly & width_mask, size32);
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            size32 <= 1'b1;
+            refin <= 1'b1;
+            refout <= 1'b1;
+            chan_en <= 4'h0;
+            poly <= 32'h04C11DB7;
+            init <= 32'hFFFFFFFF;
+            xorout <= 32'hFFFFFFFF;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        CRC_CTRL: begin
+                            size32 <= wb_data_in[0];
+                            refin <= wb_data_in[1];
+                            refout <= wb_data_in[2];
+                            chan_en <= wb_data_in[7:4];
+                        end
+                        CRC_POLY: poly <= wb_data_in;
+                        CRC_INIT: init <= wb_data_in;
+                        CRC_XOROUT: xorout <= wb_data_in;
+                        default: ; // Values are read-only
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        CRC_CTRL: wb_data_out <= {24'h0, chan_en, 1'b0, refout, refin, size32};
+                        CRC_POLY: wb_data_out <= poly;
+                        CRC_INIT: wb_data_out <= init;
+                        CRC_XOROUT: wb_data_out <= xorout;
+                        default: wb_data_out <= (wb_addr >= CRC_VALUE) ?
+                                                ((refout ? reflect(state[32*wb_addr[3:2] +: 32], size32) :
+                                                           state[32*wb_addr[3:2] +: 32]) ^ xorout) & width_mask :
+                                                32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // Running CRCs. A reset in the same cycle as a byte wins, and is
+    // sized by the SIZE bit written with it.
+    integer k;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            state <= {4{32'hFFFFFFFF}};
+        end else begin
+            for (k = 0; k < 4; k = k + 1) begin
+                if (chan_rst[k])
+                    state[32*k +: 32] <= wb_data_in[0] ? init : {16'h0, init[15:0]};
+                else if (chan_en[k] && snoop_valid[k])
+                    state[32*k +: 32] <= next;
+            end
+        end
+    end
+
+endmodule
+
+`default_nettype wire
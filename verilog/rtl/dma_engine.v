@@ -0,0 +1,349 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * dma_engine
+ *
+ * Byte-granular DMA engine that masters the user project's
+ * local bus (SPI, UART and DMA buffer windows). A transfer is
+ * described by source, destination, length and per-side
+ * stride registers; a stride of zero keeps hitting the same
+ * address, which is how a peripheral FIFO data register is
+ * drained or filled.
+ *
+ * When pacing is enabled for a side, the engine reads that
+ * window's FIFO level register before each byte so it never
+ * pops an empty RX FIFO or pushes into a full TX FIFO.
+ *
+ * Registers (offsets from the DMA block base):
+ * - 0x00 DMA_SRC    : source address (local bus, 16 bits)
+ * - 0x04 DMA_DST    : destination address (local bus, 16 bits)
+ * - 0x08 DMA_LEN    : transfer length in bytes
+ * - 0x0C DMA_STRIDE : [15:0] source stride, [31:16] destination stride
+ * - 0x10 DMA_CTRL   : [0] START, [1] SRC_PACE, [2] DST_PACE,
+ *                     [3] IRQ_EN, [4] ABORT
+ * - 0x14 DMA_STATUS : [0] BUSY, [1] DONE (write 1 to clear),
+ *                     [31:16] bytes remaining
+ *
+ * A START with DMA_LEN = 0 makes no bus access and sets DONE
+ * (and the interrupt, if enabled) right away.
+ *
+ * done_evt pulses for one cycle each time a transfer completes
+ * with IRQ_EN set, whether or not DONE was already set.
+ *
+ *-------------------------------------------------------------
+ */
+
+module dma_engine #(
+    parameter FIFO_DEPTH = 16
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [4:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Local bus master
+    output reg m_valid,
+    output reg m_we,
+    output reg [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output reg [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack,
+
+    output irq,
+    output reg done_evt
+);
+
+    // Register addresses
+    localparam DMA_SRC    = 5'h00;
+    localparam DMA_DST    = 5'h04;
+    localparam DMA_LEN    = 5'h08;
+    localparam DMA_STRIDE = 5'h0C;
+    localparam DMA_CTRL   = 5'h10;
+    localparam DMA_STATUS = 5'h14;
+
+    // Peripheral FIFO level registers, relative to a 4KB window
+    localparam RX_LEVEL_OFFSET = 12'hE00;
+    localparam TX_LEVEL_OFFSET = 12'hE10;
+
+    // Transfer states
+    localparam S_IDLE     = 3'd0;
+    localparam S_SRC_POLL = 3'd1;
+    localparam S_SRC_READ = 3'd2;
+    localparam S_DST_POLL = 3'd3;
+    localparam S_DST_WRITE = 3'd4;
+    localparam S_NEXT     = 3'd5;
+
+    // Descriptor registers
+    reg [15:0] src_reg;
+    reg [15:0] dst_reg;
+    reg [15:0] len_reg;
+    reg [15:0] src_stride;
+    reg [15:0] dst_stride;
+    reg src_pace;
+    reg dst_pace;
+    reg irq_en;
+
+    // Transfer state
+    reg [2:0] state;
+    reg [15:0] cur_src;
+    reg [15:0] cur_dst;
+    reg [15:0] remaining;
+    reg [7:0] data_byte;
+    reg done;
+    reg abort_req;
+    reg start_req;
+
+    wire busy = (state != S_IDLE);
+
+    assign irq = done && irq_en;
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            src_reg <= 16'h0;
+            dst_reg <= 16'h0;
+            len_reg <= 16'h0;
+            src_stride <= 16'h0;
+            dst_stride <= 16'h0;
+            src_pace <= 1'b0;
+            dst_pace <= 1'b0;
+            irq_en <= 1'b0;
+            start_req <= 1'b0;
+            abort_req <= 1'b0;
+        end else begin
+            wb_ack <= 1'b0;
+
+            // START and ABORT are single-cycle requests to the transfer FSM
+            if (state == S_IDLE)
+                start_req <= 1'b0;
+            if (state == S_NEXT || state == S_IDLE)
+                abort_req <= 1'b0;
+
+            if (wb_valid && !wb_ack) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        DMA_SRC: if (!busy) src_reg <= wb_data_in[15:0];
+                        DMA_DST: if (!busy) dst_reg <= wb_data_in[15:0];
+                        DMA_LEN: if (!busy) len_reg <= wb_data_in[15:0];
+                        DMA_STRIDE: if (!busy) begin
+                            src_stride <= wb_data_in[15:0];
+                            dst_stride <= wb_data_in[31:16];
+                        end
+                        DMA_CTRL: begin
+                            if (!busy) begin
+                                src_pace <= wb_data_in[1];
+                                dst_pace <= wb_data_in[2];
+                                start_req <= wb_data_in[0];
+                            end
+                            irq_en <= wb_data_in[3];
+                            if (busy && wb_data_in[4])
+                                abort_req <= 1'b1;
+                        end
+                        default: ; // DMA_STATUS is handled by the FSM
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        DMA_SRC: wb_data_out <= {16'h0, src_reg};
+                        DMA_DST: wb_data_out <= {16'h0, dst_reg};
+                        DMA_LEN: wb_data_out <= {16'h0, len_reg};
+                        DMA_STRIDE: wb_data_out <= {dst_stride, src_stride};
+                        DMA_CTRL: wb_data_out <= {28'h0, irq_en, dst_pace, src_pace, 1'b0};
+                        DMA_STATUS: wb_data_out <= {remaining, 14'h0, done, busy};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    wire done_clear = wb_valid && !wb_ack && wb_we && (wb_addr == DMA_STATUS) && wb_data_in[1];
+
+    // Byte lane selected by the low address bits of the current source
+    wire [7:0] src_byte = m_data_in >> {cur_src[1:0], 3'b000};
+
+    // Transfer FSM. Every bus access holds m_valid until m_ack and then
+    // drops it for at least one cycle, which lets the arbiter hand the
+    // local bus back to the host between bytes.
+    always @(posedge clk) begin
+        if (rst) begin
+            state <= S_IDLE;
+            m_valid <= 1'b0;
+            m_we <= 1'b0;
+            m_sel <= 4'h0;
+            m_addr <= 16'h0;
+            m_data_out <= 32'h0;
+            cur_src <= 16'h0;
+            cur_dst <= 16'h0;
+            remaining <= 16'h0;
+            data_byte <= 8'h0;
+            done <= 1'b0;
+            done_evt <= 1'b0;
+        end else begin
+            done_evt <= 1'b0;
+            if (done_clear)
+                done <= 1'b0;
+
+            case (state)
+                S_IDLE: begin
+                    if (start_req) begin
+                        cur_src <= src_reg;
+                        cur_dst <= dst_reg;
+                        remaining <= len_reg;
+                        // Nothing to move: complete straight away
+                        done <= (len_reg == 16'h0);
+                        done_evt <= (len_reg == 16'h0) && irq_en;
+                        if (len_reg != 16'h0)
+                            state <= src_pace ? S_SRC_POLL : S_SRC_READ;
+                    end
+                end
+
+                S_SRC_POLL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_sel <= 4'hF;
+                        m_addr <= {cur_src[15:12], RX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        if (m_data_in[15:0] != 16'h0)
+                            state <= S_SRC_READ;
+                        else if (abort_req)
+                            state <= S_NEXT;
+                    end
+                end
+
+                S_SRC_READ: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_sel <= 4'hF;
+                        m_addr <= {cur_src[15:2], 2'b00};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        data_byte <= src_byte;
+                        state <= dst_pace ? S_DST_POLL : S_DST_WRITE;
+                    end
+                end
+
+                S_DST_POLL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_sel <= 4'hF;
+                        m_addr <= {cur_dst[15:12], TX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        if (m_data_in[15:0] < FIFO_DEPTH - 1)
+                            state <= S_DST_WRITE;
+                        else if (abort_req)
+                            state <= S_NEXT;
+                    end
+                end
+
+                S_DST_WRITE: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b1;
+                        m_sel <= 4'b0001 << cur_dst[1:0];
+                        m_addr <= {cur_dst[15:2], 2'b00};
+                        m_data_out <= {4{data_byte}};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        m_we <= 1'b0;
+                        cur_src <= cur_src + src_stride;
+                        cur_dst <= cur_dst + dst_stride;
+                        remaining <= remaining - 16'h1;
+                        state <= S_NEXT;
+                    end
+                end
+
+                S_NEXT: begin
+                    if (remaining == 16'h0 || abort_req) begin
+                        done <= 1'b1;
+                        done_evt <= irq_en;
+                        state <= S_IDLE;
+                    end else begin
+                        state <= src_pace ? S_SRC_POLL : S_SRC_READ;
+                    end
+                end
+
+                default: state <= S_IDLE;
+            endcase
+        end
+    end
+
+endmodule
+
+// DMA staging buffer on the local bus
+module dma_buffer #(
+    parameter AW = 6
+)(
+    input clk,
+    input rst,
+    input wb_valid,
+    input wb_we,
+    input [3:0] wb_sel,
+    input [AW+1:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack
+);
+
+    reg [31:0] mem [0:(1<<AW)-1];
+
+    wire [AW-1:0] word_addr = wb_addr[AW+1:2];
+
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+        end else begin
+            wb_ack <= 1'b0;
+            if (wb_valid && !wb_ack)
+                wb_ack <= 1'b1;
+        end
+    end
+
+    // Storage is not reset
+    always @(posedge clk) begin
+        if (wb_valid && !wb_ack) begin
+            if (wb_we) begin
+                if (wb_sel[0]) mem[word_addr][7:0]   <= wb_data_in[7:0];
+                if (wb_sel[1]) mem[word_addr][15:8]  <= wb_data_in[15:8];
+                if (wb_sel[2]) mem[word_addr][23:16] <= wb_data_in[23:16];
+                if (wb_sel[3]) mem[word_addr][31:24] <= wb_data_in[31:24];
+            end else begin
+                wb_data_out <= mem[word_addr];
+            end
+        end
+    end
+
+endmodule
+
+`default_nettype wire
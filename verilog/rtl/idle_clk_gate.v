@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * idle_clk_gate
+ *
+ * Stops a peripheral core clock once the peripheral has seen no
+ * activity for 2^(idle_sel + 4) clk cycles. wake is the OR of
+ * everything that needs the core: a register access in flight,
+ * a pad edge or level. It opens the gate in the same cycle, so
+ * the first edge after wake already reaches the core and no
+ * latency is added.
+ *
+ * Each wake cycle also reloads a hold counter with hold_len,
+ * and the idle count only starts once it has run out. The
+ * counter steps on core pulses (clk cycles with src_en high),
+ * so a UART keeps its clock for a whole frame after the last
+ * edge whatever CLK_IDLE is; hold_len = 0 turns this off.
+ *
+ * src_en thins the core clock further (channel 0's fractional
+ * baud generator) and is ANDed into the one gate, so the core
+ * never sits behind two gates in series. wake, the counters and
+ * src_en are in clk. While enable is low or rst is high only
+ * src_en gates. stopped is registered so it can be synchronised
+ * elsewhere.
+ *
+ *-------------------------------------------------------------
+ */
+
+module idle_clk_gate (
+`ifdef USE_POWER_PINS
+    inout vccd1,
+    inout vssd1,
+`endif
+    input clk,
+    input rst,
+    input src_en,
+    input enable,
+    input [3:0] idle_sel,
+    input wake,
+    input [23:0] hold_len,
+    output gclk,
+    output reg stopped
+);
+
+    reg [19:0] idle_cnt;
+    reg [23:0] hold_cnt;
+
+    wire [4:0] idle_bit = {1'b0, idle_sel} + 5'd4;
+    wire expired = idle_cnt[idle_bit];
+    wire held = (hold_cnt != 24'h0);
+
+    wire idle_en = rst || !enable || wake || held || !expired;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            idle_cnt <= 20'h0;
+            hold_cnt <= 24'h0;
+            stopped <= 1'b0;
+        end else begin
+            if (wake)
+                hold_cnt <= hold_len;
+            else if (held && src_en)
+                hold_cnt <= hold_cnt - 24'h1;
+
+            if (wake || held)
+                idle_cnt <= 20'h0;
+            else if (!expired)
+                idle_cnt <= idle_cnt + 20'h1;
+            stopped <= !idle_en;
+        end
+    end
+
+    clk_gate core_gate (
+`ifdef USE_POWER_PINS
+        .vccd1(vccd1),
+        .vssd1(vssd1),
+`endif
+        .clk(clk),
+        .en(src_en && idle_en),
+        .gclk(gclk)
+    );
+
+endmodule
+
+// Clock gate: a sky130 integrated clock gating cell, which latches
+// en while clk is low so the gated clock never glitches. Verilator
+// cannot read the cell's UDP model and gets the same latch and AND.
+module clk_gate (
+`ifdef USE_POWER_PINS
+    inout vccd1,
+    inout vssd1,
+`endif
+    input clk,
+    input en,
+    output gclk
+);
+
+`ifdef VERILATOR
+    reg en_latch;
+
+    always @(clk or en) begin
+        if (!clk)
+            en_latch = en;
+    end
+
+    assign gclk = clk & en_latch;
+`else
+    sky130_fd_sc_hd__dlclkp_1 icg (
+`ifdef USE_POWER_PINS
+        .VPWR(vccd1),
+        .VGND(vssd1),
+        .VPB(vccd1),
+        .VNB(vssd1),
+`endif
+        .CLK(clk),
+        .GATE(en),
+        .GCLK(gclk)
+    );
+`endif
+
+endmodule
+
+`default_nettype wire
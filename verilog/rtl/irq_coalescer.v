@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * irq_coalescer
+ *
+ * Folds up to three event sources into one interrupt line.
+ * Each source is a strobe: every cycle it is high counts as one
+ * event, so the parent must feed single-cycle pulses per event
+ * (a byte moved, a transfer done), not level or sticky interrupt
+ * lines, which would only count once per acknowledge.
+ * The interrupt is raised once any source reaches its
+ * event threshold, or once the oldest pending event has waited
+ * TIMEOUT cycles, and stays up until firmware acknowledges
+ * every pending source through CAUSE.
+ *
+ * Registers (offsets from the coalescer block base):
+ * - 0x00 IRQC_CTRL    : [N-1:0] source enable
+ * - 0x04 IRQC_THRESH  : 8-bit event threshold per source,
+ *                       source i in [8i+7:8i] (0 behaves as 1)
+ * - 0x08 IRQC_TIMEOUT : [23:0] max latency in cycles (0: off)
+ * - 0x0C IRQC_CAUSE   : [N-1:0] PENDING (write 1 to acknowledge),
+ *                       [N+7:8] threshold reached, [16] timeout
+ * - 0x10 IRQC_COUNT   : 8-bit event count per source
+ *
+ *-------------------------------------------------------------
+ */
+
+module irq_coalescer #(
+    parameter N = 3     // 1-3
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [4:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    input [N-1:0] evt,
+    output reg irq
+);
+
+    // Register addresses
+    localparam IRQC_CTRL    = 5'h00;
+    localparam IRQC_THRESH  = 5'h04;
+    localparam IRQC_TIMEOUT = 5'h08;
+    localparam IRQC_CAUSE   = 5'h0C;
+    localparam IRQC_COUNT   = 5'h10;
+
+    reg [N-1:0] src_en;
+    reg [8*N-1:0] thresh;
+    reg [23:0] timeout;
+    reg [23:0] timer;
+    reg [8*N-1:0] count;
+
+    wire [N-1:0] event_in = evt & src_en;
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire [N-1:0] ack_src = (wb_cycle && wb_we && wb_addr == IRQC_CAUSE) ? wb_data_in[N-1:0] : {N{1'b0}};
+
+    reg [N-1:0] pending;
+    reg [N-1:0] thr_hit;
+    integer i, j;
+
+    always @(*) begin
+        for (i = 0; i < N; i = i + 1) begin
+            pending[i] = (count[8*i +: 8] != 8'h0);
+            thr_hit[i] = pending[i] && (count[8*i +: 8] >= thresh[8*i +: 8]);
+        end
+    end
+
+    wire to_hit = (timeout != 24'h0) && (timer >= timeout);
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            src_en <= {N{1'b0}};
+            thresh <= {N{8'h01}};
+            timeout <= 24'h0;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        IRQC_CTRL: src_en <= wb_data_in[N-1:0];
+                        IRQC_THRESH: thresh <= wb_data_in[8*N-1:0];
+                        IRQC_TIMEOUT: timeout <= wb_data_in[23:0];
+                        default: ; // CAUSE is handled with the counters
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        IRQC_CTRL: wb_data_out <= {{(32-N){1'b0}}, src_en};
+                        IRQC_THRESH: wb_data_out <= {{(32-8*N){1'b0}}, thresh};
+                        IRQC_TIMEOUT: wb_data_out <= {8'h0, timeout};
+                        IRQC_CAUSE: wb_data_out <= {15'h0, to_hit, {(8-N){1'b0}}, thr_hit,
+                                                    {(8-N){1'b0}}, pending};
+                        IRQC_COUNT: wb_data_out <= {{(32-8*N){1'b0}}, count};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // Event counters and latency timer. An event arriving in the same
+    // cycle as its acknowledge is kept as the first event of the next
+    // batch.
+    always @(posedge clk) begin
+        if (rst) begin
+            count <= {8*N{1'b0}};
+            timer <= 24'h0;
+            irq <= 1'b0;
+        end else begin
+            for (j = 0; j < N; j = j + 1) begin
+                if (ack_src[j])
+                    count[8*j +: 8] <= {7'h0, event_in[j]};
+                else if (event_in[j] && count[8*j +: 8] != 8'hFF)
+                    count[8*j +: 8] <= count[8*j +: 8] + 8'h1;
+            end
+
+            if (!(|pending))
+                timer <= 24'h0;
+            else if (!to_hit)
+                timer <= timer + 24'h1;
+
+            if (|thr_hit || to_hit)
+                irq <= 1'b1;
+            else if (!(|pending))
+                irq <= 1'b0;
+        end
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * la_mailbox
+ *
+ * Logic analyzer side channel into the SPI and UART channel 0
+ * FIFOs. The management core hands over up to 16 bytes per
+ * push on la_data_in and gets up to 15 bytes per pop back on
+ * la_data_out; la_oenb carries the request toggles. While
+ * enabled the mailbox masters the local bus like stream_bridge,
+ * pacing its FIFO accesses against the level registers.
+ *
+ * The LA is in the Wishbone clock domain, and firmware updates
+ * la_data_in before the la_oenb word that toggles a request,
+ * so one register stage is enough. A push word is copied when
+ * the push is taken, so the next one can be staged while the
+ * previous one drains; it is taken once that has finished.
+ *
+ * Requests (la_ctrl, reg_la0_oenb[7:0] as firmware wrote it):
+ * - [0]   PUSH : toggle to write la_data_in bytes 0..N-1
+ * - [1]   POP  : toggle to read up to 15 received bytes
+ * - [2]   PUSH target, [3] POP target (0: SPI, 1: UART)
+ * - [7:4] N - 1 for PUSH
+ *
+ * Response (la_out):
+ * - [119:0]   popped bytes, byte 0 in [7:0]
+ * - [123:120] bytes popped (0 if the RX FIFO was empty)
+ * - [126]     POP_ACK : equals POP once the pop is done
+ * - [127]     PUSH_ACK: equals PUSH once the push has been
+ *             taken and la_data_in may be reloaded
+ *
+ * While enable is low the acks follow the request toggles, so
+ * nothing stale runs when the mailbox is turned on.
+ *
+ *-------------------------------------------------------------
+ */
+
+module la_mailbox #(
+    parameter FIFO_DEPTH = 16,
+    parameter SPI_WIN = 4'h0,
+    parameter UART_WIN = 4'h1
+)(
+    input clk,
+    input rst,
+    input enable,
+
+    // Logic analyzer
+    input [127:0] la_in,
+    input [7:0] la_ctrl,
+    output [127:0] la_out,
+
+    // Local bus master
+    output reg m_valid,
+    output reg m_we,
+    output [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output reg [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack
+);
+
+    // Register offsets inside a peripheral window
+    localparam RXDATA_OFFSET = 12'h000;
+    localparam TXDATA_OFFSET = 12'h004;
+    localparam RX_LEVEL_OFFSET = 12'hE00;
+    localparam TX_LEVEL_OFFSET = 12'hE10;
+
+    // Mailbox states
+    localparam S_IDLE       = 3'd0;
+    localparam S_PUSH_LEVEL = 3'd1;
+    localparam S_PUSH_WRITE = 3'd2;
+    localparam S_POP_LEVEL  = 3'd3;
+    localparam S_POP_READ   = 3'd4;
+
+    reg [127:0] la_in_q;
+    reg [7:0] la_ctrl_q;
+
+    reg [2:0] state;
+    reg push_seen;      // last request taken
+    reg pop_seen;
+    reg push_ack;
+    reg pop_ack;
+    reg [3:0] win;
+    reg [127:0] push_data;
+    reg [3:0] push_idx;
+    reg [4:0] push_left;
+    reg [4:0] burst;
+    reg [119:0] pop_data;
+    reg [3:0] pop_idx;
+    reg [3:0] pop_count;
+
+    wire push_req = (la_ctrl_q[0] != push_seen);
+    wire pop_req = (la_ctrl_q[1] != pop_seen);
+
+    wire [15:0] level = m_data_in[15:0];
+    // Room a write can use; one entry stays free
+    localparam [15:0] ROOM_MAX = FIFO_DEPTH - 1;
+    wire [15:0] room = (level < ROOM_MAX) ? (ROOM_MAX - level) : 16'h0;
+
+    assign m_sel = 4'hF;
+    assign la_out = {push_ack, pop_ack, 2'b0, pop_count, pop_data};
+
+    always @(posedge clk) begin
+        if (rst) begin
+            la_in_q <= 128'h0;
+            la_ctrl_q <= 8'h0;
+        end else begin
+            la_in_q <= la_in;
+            la_ctrl_q <= la_ctrl;
+        end
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            state <= S_IDLE;
+            push_seen <= 1'b0;
+            pop_seen <= 1'b0;
+            push_ack <= 1'b0;
+            pop_ack <= 1'b0;
+            win <= 4'h0;
+            push_data <= 128'h0;
+            push_idx <= 4'h0;
+            push_left <= 5'h0;
+            burst <= 5'h0;
+            pop_data <= 120'h0;
+            pop_idx <= 4'h0;
+            pop_count <= 4'h0;
+            m_valid <= 1'b0;
+            m_we <= 1'b0;
+            m_addr <= 16'h0;
+            m_data_out <= 32'h0;
+        end else begin
+            case (state)
+                S_IDLE: begin
+                    if (!enable) begin
+                        push_seen <= la_ctrl_q[0];
+                        pop_seen <= la_ctrl_q[1];
+                        push_ack <= la_ctrl_q[0];
+                        pop_ack <= la_ctrl_q[1];
+                    end else if (push_req) begin
+                        push_seen <= la_ctrl_q[0];
+                        push_ack <= la_ctrl_q[0];
+                        win <= la_ctrl_q[2] ? UART_WIN : SPI_WIN;
+                        push_data <= la_in_q;
+                        push_idx <= 4'h0;
+                        push_left <= {1'b0, la_ctrl_q[7:4]} + 5'h1;
+                        state <= S_PUSH_LEVEL;
+                    end else if (pop_req) begin
+                        pop_seen <= la_ctrl_q[1];
+                        win <= la_ctrl_q[3] ? UART_WIN : SPI_WIN;
+                        pop_idx <= 4'h0;
+                        state <= S_POP_LEVEL;
+                    end
+                end
+
+                S_PUSH_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {win, TX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        burst <= (room < {11'h0, push_left}) ? room[4:0] : push_left;
+                        if (room != 16'h0)
+                            state <= S_PUSH_WRITE;
+                    end
+                end
+
+                S_PUSH_WRITE: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b1;
+                        m_addr <= {win, TXDATA_OFFSET};
+                        m_data_out <= {24'h0, push_data[8*push_idx +: 8]};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        m_we <= 1'b0;
+                        push_idx <= push_idx + 4'h1;
+                        push_left <= push_left - 5'h1;
+                        burst <= burst - 5'h1;
+                        if (push_left == 5'h1) begin
+                            state <= S_IDLE;
+                        end else if (burst == 5'h1) begin
+                            state <= S_PUSH_LEVEL;
+                        end
+                    end
+                end
+
+                S_POP_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {win, RX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        burst <= (level < 16'd15) ? level[4:0] : 5'd15;
+                        if (level != 16'h0) begin
+                            state <= S_POP_READ;
+                        end else begin
+                            pop_count <= 4'h0;
+                            pop_ack <= pop_seen;
+                            state <= S_IDLE;
+                        end
+                    end
+                end
+
+                S_POP_READ: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {win, RXDATA_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        pop_data[8*pop_idx +: 8] <= m_data_in[7:0];
+                        pop_idx <= pop_idx + 4'h1;
+                        burst <= burst - 5'h1;
+                        if (burst == 5'h1) begin
+                            pop_count <= pop_idx + 4'h1;
+                            pop_ack <= pop_seen;
+                            state <= S_IDLE;
+                        end
+                    end
+                end
+
+                default: state <= S_IDLE;
+            endcase
+        end
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,322 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * qspi_master
+ *
+ * Single/dual/quad SPI master (mode 0). Every TX FIFO entry is
+ * one byte plus its own lane width and direction, so a flash
+ * read (x1 opcode, x4 address, dummy cycles, x4 data) is just a
+ * sequence of TXDATA writes while CTRL.SS holds CSB low.
+ *
+ * The register offsets follow the CF IP layout so the DMA
+ * engine can pace against the FIFO level registers.
+ *
+ * Registers:
+ * - 0x0000 RXDATA : [7:0] received byte (read pops)
+ * - 0x0004 TXDATA : [7:0] data, [9:8] width (0: x1, 1: x2, 2: x4),
+ *                   [10] READ (push the sampled byte to RX; x2/x4
+ *                   lanes are released to inputs)
+ * - 0x000C CTRL   : [0] EN (take over the SPI pads), [1] SS (CSB low)
+ * - 0x0010 PR     : SCLK half period in clock cycles (minimum 1)
+ * - 0x0014 STATUS : [0] BUSY, [1] TX_EMPTY, [2] TX_FULL,
+ *                   [3] RX_EMPTY, [4] RX_FULL
+ * - 0xFE00 RX_FIFO_LEVEL
+ * - 0xFE10 TX_FIFO_LEVEL
+ *
+ *-------------------------------------------------------------
+ */
+
+module qspi_master #(
+    parameter FAW = 4
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [15:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Pads
+    output pad_en,
+    output sclk,
+    output csb,
+    output [3:0] io_out,
+    output [3:0] io_oe,
+    input [3:0] io_in
+);
+
+    // Register addresses
+    localparam RXDATA_REG = 16'h0000;
+    localparam TXDATA_REG = 16'h0004;
+    localparam CTRL_REG = 16'h000C;
+    localparam PR_REG = 16'h0010;
+    localparam STATUS_REG = 16'h0014;
+    localparam RX_LEVEL_REG = 16'hFE00;
+    localparam TX_LEVEL_REG = 16'hFE10;
+
+    // Lane widths
+    localparam W_X1 = 2'd0;
+    localparam W_X2 = 2'd1;
+    localparam W_X4 = 2'd2;
+
+    reg en;
+    reg ss;
+    reg [15:0] prescale;
+
+    // FIFOs
+    wire [10:0] tx_rd_data;
+    wire tx_empty, tx_full;
+    wire [FAW:0] tx_level;
+    wire [7:0] rx_rd_data;
+    wire rx_empty, rx_full;
+    wire [FAW:0] rx_level;
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire tx_push = wb_cycle && wb_we && (wb_addr == TXDATA_REG) && !tx_full;
+    wire rx_pop = wb_cycle && !wb_we && (wb_addr == RXDATA_REG) && !rx_empty;
+
+    reg tx_pop;
+    reg rx_push;
+    reg [7:0] rx_push_data;
+
+    qspi_fifo #(
+        .DW(11),
+        .AW(FAW)
+    ) tx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(tx_push),
+        .wr_data(wb_data_in[10:0]),
+        .rd(tx_pop),
+        .rd_data(tx_rd_data),
+        .empty(tx_empty),
+        .full(tx_full),
+        .level(tx_level)
+    );
+
+    qspi_fifo #(
+        .DW(8),
+        .AW(FAW)
+    ) rx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(rx_push),
+        .wr_data(rx_push_data),
+        .rd(rx_pop),
+        .rd_data(rx_rd_data),
+        .empty(rx_empty),
+        .full(rx_full),
+        .level(rx_level)
+    );
+
+    // Shift engine
+    reg busy;
+    reg sclk_q;
+    reg [15:0] div_cnt;
+    reg [7:0] tx_shift;
+    reg [7:0] rx_shift;
+    reg [3:0] beats;
+    reg [1:0] width;
+    reg rd_mode;
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            en <= 1'b0;
+            ss <= 1'b0;
+            prescale <= 16'h1;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        CTRL_REG: begin
+                            en <= wb_data_in[0];
+                            ss <= wb_data_in[1];
+                        end
+                        PR_REG: prescale <= (wb_data_in[15:0] == 16'h0) ? 16'h1 : wb_data_in[15:0];
+                        default: ; // TXDATA handled by the FIFO
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        RXDATA_REG: wb_data_out <= {24'h0, rx_rd_data};
+                        CTRL_REG: wb_data_out <= {30'h0, ss, en};
+                        PR_REG: wb_data_out <= {16'h0, prescale};
+                        STATUS_REG: wb_data_out <= {27'h0, rx_full, rx_empty, tx_full, tx_empty, busy};
+                        RX_LEVEL_REG: wb_data_out <= {{(31-FAW){1'b0}}, rx_level};
+                        TX_LEVEL_REG: wb_data_out <= {{(31-FAW){1'b0}}, tx_level};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // Bits moved per SCLK beat
+    wire [7:0] rx_next = (width == W_X4) ? {rx_shift[3:0], io_in[3:0]} :
+                         (width == W_X2) ? {rx_shift[5:0], io_in[1:0]} :
+                                           {rx_shift[6:0], io_in[1]};
+    wire [7:0] tx_next = (width == W_X4) ? {tx_shift[3:0], 4'h0} :
+                         (width == W_X2) ? {tx_shift[5:0], 2'h0} :
+                                           {tx_shift[6:0], 1'b0};
+
+    // Mode 0: lanes change while SCLK is low and are sampled on the
+    // rising edge. Back-to-back FIFO entries keep CSB low and only add
+    // one cycle of SCLK low time between bytes.
+    always @(posedge clk) begin
+        if (rst) begin
+            busy <= 1'b0;
+            sclk_q <= 1'b0;
+            div_cnt <= 16'h0;
+            tx_shift <= 8'h0;
+            rx_shift <= 8'h0;
+            beats <= 4'h0;
+            width <= W_X1;
+            rd_mode <= 1'b0;
+            tx_pop <= 1'b0;
+            rx_push <= 1'b0;
+            rx_push_data <= 8'h0;
+        end else begin
+            tx_pop <= 1'b0;
+            rx_push <= 1'b0;
+
+            if (!busy) begin
+                sclk_q <= 1'b0;
+                if (!ss) begin
+                    // CSB high: lanes go back to their x1 directions
+                    width <= W_X1;
+                    rd_mode <= 1'b0;
+                end
+                if (en && ss && !tx_empty && !tx_pop) begin
+                    busy <= 1'b1;
+                    tx_pop <= 1'b1;
+                    tx_shift <= tx_rd_data[7:0];
+                    width <= tx_rd_data[9:8];
+                    rd_mode <= tx_rd_data[10];
+                    beats <= (tx_rd_data[9:8] == W_X4) ? 4'd2 :
+                             (tx_rd_data[9:8] == W_X2) ? 4'd4 : 4'd8;
+                    div_cnt <= prescale;
+                end
+            end else if (div_cnt != 16'h1) begin
+                div_cnt <= div_cnt - 16'h1;
+            end else begin
+                div_cnt <= prescale;
+                sclk_q <= ~sclk_q;
+                if (!sclk_q) begin
+                    // Rising edge: sample
+                    rx_shift <= rx_next;
+                end else begin
+                    // Falling edge: advance or finish the byte
+                    tx_shift <= tx_next;
+                    beats <= beats - 4'h1;
+                    if (beats == 4'h1) begin
+                        busy <= 1'b0;
+                        if (rd_mode && !rx_full) begin
+                            rx_push <= 1'b1;
+                            rx_push_data <= rx_shift;
+                        end
+                    end
+                end
+            end
+        end
+    end
+
+    // Pad drive. IO0 stays an output in x1 mode (MOSI) and IO1 an input
+    // (MISO). Outside x4 transfers IO2/IO3 are held high as outputs,
+    // which keeps WP#/HOLD# inactive on a serial flash. While CSB is low
+    // the lanes keep the direction of the last entry between entries,
+    // so back-to-back x2/x4 reads never drive against the slave, which
+    // puts out its next bits on the falling edge that ends a byte.
+    wire lanes_held = busy || ss;
+    wire multi_lane = lanes_held && (width != W_X1);
+    wire quad_lane = lanes_held && (width == W_X4);
+
+    assign pad_en = en;
+    assign sclk = sclk_q;
+    assign csb = !ss;
+    assign io_out[0] = (width == W_X4) ? tx_shift[4] : (width == W_X2) ? tx_shift[6] : tx_shift[7];
+    assign io_out[1] = (width == W_X4) ? tx_shift[5] : tx_shift[7];
+    assign io_out[2] = quad_lane ? tx_shift[6] : 1'b1;
+    assign io_out[3] = quad_lane ? tx_shift[7] : 1'b1;
+    assign io_oe[0] = !(multi_lane && rd_mode);
+    assign io_oe[1] = multi_lane && !rd_mode;
+    assign io_oe[2] = !(quad_lane && rd_mode);
+    assign io_oe[3] = !(quad_lane && rd_mode);
+
+endmodule
+
+// Synchronous FIFO used by the QSPI master
+module qspi_fifo #(
+    parameter DW = 8,
+    parameter AW = 4
+)(
+    input clk,
+    input rst,
+    input wr,
+    input [DW-1:0] wr_data,
+    input rd,
+    output [DW-1:0] rd_data,
+    output empty,
+    output full,
+    output reg [AW:0] level
+);
+
+    reg [DW-1:0] mem [0:(1<<AW)-1];
+    reg [AW-1:0] wr_ptr;
+    reg [AW-1:0] rd_ptr;
+
+    assign empty = (level == {(AW+1){1'b0}});
+    assign full = (level == (1 << AW));
+    assign rd_data = mem[rd_ptr];
+
+    always @(posedge clk) begin
+        if (rst) begin
+            wr_ptr <= {AW{1'b0}};
+            rd_ptr <= {AW{1'b0}};
+            level <= {(AW+1){1'b0}};
+        end else begin
+            if (wr && !full)
+                wr_ptr <= wr_ptr + 1'b1;
+            if (rd && !empty)
+                rd_ptr <= rd_ptr + 1'b1;
+            case ({wr && !full, rd && !empty})
+                2'b10: level <= level + 1'b1;
+                2'b01: level <= level - 1'b1;
+                default: ;
+            endcase
+        end
+    end
+
+    always @(posedge clk) begin
+        if (wr && !full)
+            mem[wr_ptr] <= wr_data;
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * spi_slave
+ *
+ * SPI slave (modes 0-3) for an external host. SCLK, CSB and
+ * MOSI are synchronised into clk and edge-detected, and MISO
+ * is the tx_shift flop, which the parent must route to the pad
+ * without a further register. MISO then changes at most 3 clk
+ * after the SCLK shift edge (2 synchroniser stages, 1 to shift)
+ * and CSB falling, so each SCLK phase must last at least 4 clk:
+ * SCLK at most clk/8, first edge 4 clk after CSB. Every byte
+ * received goes to the RX FIFO; every byte sent is popped from
+ * the TX FIFO, or is 0xFF if it was empty, in which case
+ * UNDERRUN is set once the host clocks it. MISO is only driven
+ * while CSB is low. overrun_evt and underrun_evt pulse once for
+ * every byte dropped or sent empty, whatever the sticky flags.
+ *
+ * The register offsets follow the CF IP layout so the DMA
+ * engine can pace against the FIFO level registers.
+ *
+ * Registers:
+ * - 0x0000 RXDATA : [7:0] received byte (read pops)
+ * - 0x0004 TXDATA : [7:0] byte for the host
+ * - 0x0008 CFG    : [0] CPOL, [1] CPHA
+ * - 0x0014 STATUS : [0] SELECTED, [1] TX_EMPTY, [2] TX_FULL,
+ *                   [3] RX_EMPTY, [4] RX_FULL, [5] OVERRUN,
+ *                   [6] UNDERRUN (write 1 to clear [6:5])
+ * - 0xFE00 RX_FIFO_LEVEL
+ * - 0xFE10 TX_FIFO_LEVEL
+ * - 0xFF00 IM     : [0] RX not empty, [1] OVERRUN
+ *
+ *-------------------------------------------------------------
+ */
+
+module spi_slave #(
+    parameter FAW = 4
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [15:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Pads (asynchronous to clk)
+    input enable,
+    input sclk,
+    input csb,
+    input mosi,
+    output miso,
+    output miso_oe,
+
+    output selected,
+    output irq,
+    output overrun_evt,
+    output underrun_evt
+);
+
+    // Register addresses
+    localparam RXDATA_REG = 16'h0000;
+    localparam TXDATA_REG = 16'h0004;
+    localparam CFG_REG = 16'h0008;
+    localparam STATUS_REG = 16'h0014;
+    localparam RX_LEVEL_REG = 16'hFE00;
+    localparam TX_LEVEL_REG = 16'hFE10;
+    localparam IM_REG = 16'hFF00;
+
+    reg cpol;
+    reg cpha;
+    reg [1:0] im;
+    reg overrun;
+    reg underrun;
+
+    // FIFOs
+    wire [7:0] tx_rd_data;
+    wire tx_empty, tx_full;
+    wire [FAW:0] tx_level;
+    wire [7:0] rx_rd_data;
+    wire rx_empty, rx_full;
+    wire [FAW:0] rx_level;
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire tx_push = wb_cycle && wb_we && (wb_addr == TXDATA_REG) && !tx_full;
+    wire rx_pop = wb_cycle && !wb_we && (wb_addr == RXDATA_REG) && !rx_empty;
+    wire flag_clr = wb_cycle && wb_we && (wb_addr == STATUS_REG);
+
+    reg tx_pop;
+    reg rx_push;
+    reg [7:0] rx_push_data;
+
+    qspi_fifo #(
+        .DW(8),
+        .AW(FAW)
+    ) tx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(tx_push),
+        .wr_data(wb_data_in[7:0]),
+        .rd(tx_pop),
+        .rd_data(tx_rd_data),
+        .empty(tx_empty),
+        .full(tx_full),
+        .level(tx_level)
+    );
+
+    qspi_fifo #(
+        .DW(8),
+        .AW(FAW)
+    ) rx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(rx_push),
+        .wr_data(rx_push_data),
+        .rd(rx_pop),
+        .rd_data(rx_rd_data),
+        .empty(rx_empty),
+        .full(rx_full),
+        .level(rx_level)
+    );
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            cpol <= 1'b0;
+            cpha <= 1'b0;
+            im <= 2'h0;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        CFG_REG: begin
+                            cpol <= wb_data_in[0];
+                            cpha <= wb_data_in[1];
+                        end
+                        IM_REG: im <= wb_data_in[1:0];
+                        default: ; // TXDATA and STATUS handled below
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        RXDATA_REG: wb_data_out <= {24'h0, rx_rd_data};
+                        CFG_REG: wb_data_out <= {30'h0, cpha, cpol};
+                        STATUS_REG: wb_data_out <= {25'h0, underrun, overrun, rx_full, rx_empty,
+                                                    tx_full, tx_empty, selected};
+                        RX_LEVEL_REG: wb_data_out <= {{(31-FAW){1'b0}}, rx_level};
+                        TX_LEVEL_REG: wb_data_out <= {{(31-FAW){1'b0}}, tx_level};
+                        IM_REG: wb_data_out <= {30'h0, im};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // Pad synchronisers: {CSB, SCLK, MOSI}
+    wire csb_s, sclk_s, mosi_s;
+
+    cdc_sync #(
+        .WIDTH(3)
+    ) pad_sync (
+        .clk(clk),
+        .rst(rst),
+        .d({csb, sclk, mosi}),
+        .q({csb_s, sclk_s, mosi_s})
+    );
+
+    reg csb_q;
+    reg sclk_q;
+
+    // Modes 0 and 3 sample on the rising edge, 1 and 2 on the falling
+    // edge; data changes on the other edge. With CPHA = 0 the first bit
+    // is presented as soon as CSB falls.
+    wire active = enable && !csb_s;
+    wire sel_edge = enable && csb_q && !csb_s;
+    wire sclk_rise = sclk_s && !sclk_q;
+    wire sclk_fall = !sclk_s && sclk_q;
+    wire sample_edge = active && !sel_edge && ((cpol ^ cpha) ? sclk_fall : sclk_rise);
+    wire shift_edge = active && !sel_edge && ((cpol ^ cpha) ? sclk_rise : sclk_fall);
+
+    reg [7:0] rx_shift;
+    reg [7:0] tx_shift;
+    reg [2:0] bit_cnt;
+    reg load_pending;
+    reg tx_loaded;
+
+    wire [7:0] tx_next = tx_empty ? 8'hFF : tx_rd_data;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            csb_q <= 1'b1;
+            sclk_q <= 1'b0;
+            rx_shift <= 8'h0;
+            tx_shift <= 8'hFF;
+            bit_cnt <= 3'h0;
+            load_pending <= 1'b0;
+            tx_loaded <= 1'b0;
+            tx_pop <= 1'b0;
+            rx_push <= 1'b0;
+            rx_push_data <= 8'h0;
+            overrun <= 1'b0;
+            underrun <= 1'b0;
+        end else begin
+            csb_q <= csb_s;
+            sclk_q <= sclk_s;
+            tx_pop <= 1'b0;
+            rx_push <= 1'b0;
+
+            if (flag_clr) begin
+                if (wb_data_in[5])
+                    overrun <= 1'b0;
+                if (wb_data_in[6])
+                    underrun <= 1'b0;
+            end
+
+            if (sel_edge) begin
+                bit_cnt <= 3'h0;
+                if (cpha) begin
+                    load_pending <= 1'b1;
+                end else begin
+                    tx_shift <= tx_next;
+                    tx_pop <= !tx_empty;
+                    load_pending <= 1'b0;
+                    tx_loaded <= !tx_empty;
+                end
+            end
+
+            if (sample_edge) begin
+                rx_shift <= {rx_shift[6:0], mosi_s};
+                bit_cnt <= bit_cnt + 3'h1;
+                if (bit_cnt == 3'h0 && !tx_loaded)
+                    underrun <= 1'b1;
+                if (bit_cnt == 3'h7) begin
+                    if (rx_full) begin
+                        overrun <= 1'b1;
+                    end else begin
+                        rx_push <= 1'b1;
+                        rx_push_data <= {rx_shift[6:0], mosi_s};
+                    end
+                    load_pending <= 1'b1;
+                end
+            end
+
+            if (shift_edge) begin
+                if (load_pending) begin
+                    tx_shift <= tx_next;
+                    tx_pop <= !tx_empty;
+                    load_pending <= 1'b0;
+                    tx_loaded <= !tx_empty;
+                end else begin
+                    tx_shift <= {tx_shift[6:0], 1'b1};
+                end
+            end
+        end
+    end
+
+    assign miso = tx_shift[7];
+    assign miso_oe = active;
+    assign selected = active;
+    assign irq = (im[0] && !rx_empty) || (im[1] && overrun);
+    assign overrun_evt = sample_edge && (bit_cnt == 3'h7) && rx_full;
+    assign underrun_evt = sample_edge && (bit_cnt == 3'h0) && !tx_loaded;
+
+endmodule
+
+`default_nettype wire
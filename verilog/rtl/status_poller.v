@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * status_poller
+ *
+ * On-demand refresh of the SPI and UART channel 0 FIFO and
+ * error state. The CF IPs only expose it through registers, so
+ * while enabled each start pulse (a SNAPSHOT read) runs one
+ * round: the poller masters the local bus and reads, in turn,
+ * the SPI RX/TX FIFO levels, the UART RX/TX FIFO levels, the
+ * UART raw interrupt status and the SPI slave status, keeps the
+ * latest value of each, and goes quiet again. A start during a
+ * round is ignored. Between rounds it makes no bus accesses, so
+ * it never holds the serial cores' clock gates open. With
+ * spi_slave set the SPI levels are taken from the SPI slave
+ * instead of the master.
+ *
+ * Levels are clamped to FIFO_DEPTH, which must be 16 so each
+ * fits in five bits with bit 4 set only when the FIFO is full.
+ *
+ * status:
+ * - [4:0]   SPI RX FIFO level
+ * - [9:5]   SPI TX FIFO level
+ * - [14:10] UART RX FIFO level
+ * - [19:15] UART TX FIFO level
+ * - [23:20] UART errors: framing, parity, overrun, break
+ * - [25:24] SPI slave errors: overrun, underrun
+ *
+ * valid is set once a round has completed since enable went
+ * high.
+ *
+ *-------------------------------------------------------------
+ */
+
+module status_poller #(
+    parameter FIFO_DEPTH = 16,
+    parameter SPI_WIN = 4'h0,
+    parameter UART_WIN = 4'h1,
+    parameter SSLV_WIN = 4'hE
+)(
+    input clk,
+    input rst,
+    input enable,
+    input start,
+    input spi_slave,
+
+    // Local bus master
+    output reg m_valid,
+    output m_we,
+    output [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack,
+
+    output reg [25:0] status,
+    output reg valid
+);
+
+    // Register offsets inside a peripheral window
+    localparam RX_LEVEL_OFFSET = 12'hE00;
+    localparam TX_LEVEL_OFFSET = 12'hE10;
+    localparam RIS_OFFSET = 12'hF08;
+    localparam SSLV_STATUS_OFFSET = 12'h014;
+
+    // Poll steps, one register read each
+    localparam P_SPI_RX  = 3'd0;
+    localparam P_SPI_TX  = 3'd1;
+    localparam P_UART_RX = 3'd2;
+    localparam P_UART_TX = 3'd3;
+    localparam P_UART_RIS = 3'd4;
+    localparam P_SSLV    = 3'd5;
+
+    // CF_UART raw interrupt status bits
+    localparam RIS_BRK = 4;
+    localparam RIS_FE  = 6;
+    localparam RIS_PRE = 7;
+    localparam RIS_OR  = 8;
+
+    reg [2:0] step;
+    reg running;
+
+    wire [3:0] spi_win = spi_slave ? SSLV_WIN : SPI_WIN;
+    wire [4:0] level = (m_data_in[15:0] >= FIFO_DEPTH) ? FIFO_DEPTH : m_data_in[4:0];
+
+    assign m_we = 1'b0;
+    assign m_sel = 4'hF;
+    assign m_data_out = 32'h0;
+
+    always @(*) begin
+        case (step)
+            P_SPI_RX:   m_addr = {spi_win, RX_LEVEL_OFFSET};
+            P_SPI_TX:   m_addr = {spi_win, TX_LEVEL_OFFSET};
+            P_UART_RX:  m_addr = {UART_WIN, RX_LEVEL_OFFSET};
+            P_UART_TX:  m_addr = {UART_WIN, TX_LEVEL_OFFSET};
+            P_UART_RIS: m_addr = {UART_WIN, RIS_OFFSET};
+            default:    m_addr = {SSLV_WIN, SSLV_STATUS_OFFSET};
+        endcase
+    end
+
+    // The address follows step, which only advances on the ack that
+    // ends the access using it
+    always @(posedge clk) begin
+        if (rst) begin
+            m_valid <= 1'b0;
+            step <= P_SPI_RX;
+            running <= 1'b0;
+            status <= 26'h0;
+            valid <= 1'b0;
+        end else begin
+            if (!m_valid) begin
+                if (!enable) begin
+                    step <= P_SPI_RX;
+                    running <= 1'b0;
+                    valid <= 1'b0;
+                end else if (running || start) begin
+                    running <= 1'b1;
+                    m_valid <= 1'b1;
+                end
+            end else if (m_ack) begin
+                m_valid <= 1'b0;
+                step <= (step == P_SSLV) ? P_SPI_RX : step + 3'd1;
+                if (step == P_SSLV) begin
+                    running <= 1'b0;
+                    valid <= 1'b1;
+                end
+
+                case (step)
+                    P_SPI_RX:   status[4:0] <= level;
+                    P_SPI_TX:   status[9:5] <= level;
+                    P_UART_RX:  status[14:10] <= level;
+                    P_UART_TX:  status[19:15] <= level;
+                    P_UART_RIS: status[23:20] <= {m_data_in[RIS_BRK], m_data_in[RIS_OR],
+                                                  m_data_in[RIS_PRE], m_data_in[RIS_FE]};
+                    default:    status[25:24] <= m_data_in[6:5];
+                endcase
+            end
+        end
+    end
+
+endmodule
+
+`default_nettype wire
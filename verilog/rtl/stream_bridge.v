@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * stream_bridge
+ *
+ * Hardware SPI <-> UART forwarding. When a direction is
+ * enabled the bridge masters the local bus, reads the source
+ * RX FIFO level and the destination TX FIFO level, and then
+ * moves as many bytes as both allow before re-polling.
+ *
+ * - enable[0]: SPI RX FIFO  -> UART TX FIFO
+ * - enable[1]: UART RX FIFO -> SPI TX FIFO
+ *
+ * Both directions are serviced alternately, so a full-duplex
+ * bridge (UART bytes clock the SPI, SPI replies go back out of
+ * the UART) needs no firmware once enabled.
+ *
+ *-------------------------------------------------------------
+ */
+
+module stream_bridge #(
+    parameter FIFO_DEPTH = 16,
+    parameter SPI_WIN = 4'h0,
+    parameter UART_WIN = 4'h1
+)(
+    input clk,
+    input rst,
+    input [1:0] enable,
+
+    // Local bus master
+    output reg m_valid,
+    output reg m_we,
+    output [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output reg [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack
+);
+
+    // Register offsets inside a peripheral window
+    localparam RXDATA_OFFSET = 12'h000;
+    localparam TXDATA_OFFSET = 12'h004;
+    localparam RX_LEVEL_OFFSET = 12'hE00;
+    localparam TX_LEVEL_OFFSET = 12'hE10;
+
+    // Bridge states
+    localparam S_IDLE      = 3'd0;
+    localparam S_SRC_LEVEL = 3'd1;
+    localparam S_DST_LEVEL = 3'd2;
+    localparam S_READ      = 3'd3;
+    localparam S_WRITE     = 3'd4;
+    localparam S_SWITCH    = 3'd5;
+
+    reg [2:0] state;
+    reg dir;            // 0: SPI -> UART, 1: UART -> SPI
+    reg [15:0] avail;
+    reg [15:0] count;
+
+    wire [3:0] src_win = dir ? UART_WIN : SPI_WIN;
+    wire [3:0] dst_win = dir ? SPI_WIN : UART_WIN;
+
+    wire [15:0] level = m_data_in[15:0];
+    // Room a write can use; one entry stays free
+    localparam [15:0] ROOM_MAX = FIFO_DEPTH - 1;
+    wire [15:0] room = (level < ROOM_MAX) ? (ROOM_MAX - level) : 16'h0;
+
+    assign m_sel = 4'hF;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            state <= S_IDLE;
+            dir <= 1'b0;
+            avail <= 16'h0;
+            count <= 16'h0;
+            m_valid <= 1'b0;
+            m_we <= 1'b0;
+            m_addr <= 16'h0;
+            m_data_out <= 32'h0;
+        end else begin
+            case (state)
+                S_IDLE: begin
+                    if (enable[dir])
+                        state <= S_SRC_LEVEL;
+                    else if (enable[!dir])
+                        dir <= ~dir;
+                end
+
+                S_SRC_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {src_win, RX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        avail <= level;
+                        state <= (level != 16'h0) ? S_DST_LEVEL : S_SWITCH;
+                    end
+                end
+
+                S_DST_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {dst_win, TX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        count <= (room < avail) ? room : avail;
+                        state <= (room != 16'h0) ? S_READ : S_SWITCH;
+                    end
+                end
+
+                S_READ: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {src_win, RXDATA_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        m_data_out <= {24'h0, m_data_in[7:0]};
+                        state <= S_WRITE;
+                    end
+                end
+
+                S_WRITE: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b1;
+                        m_addr <= {dst_win, TXDATA_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        m_we <= 1'b0;
+                        count <= count - 16'h1;
+                        state <= (count == 16'h1) ? S_SWITCH : S_READ;
+                    end
+                end
+
+                S_SWITCH: begin
+                    if (enable[!dir])
+                        dir <= ~dir;
+                    state <= S_IDLE;
+                end
+
+                default: state <= S_IDLE;
+            endcase
+        end
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,285 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * trace_buffer
+ *
+ * Triggered trace RAM. While armed, every enabled event is
+ * written into a ring of 2^AW entries with a 32-bit cycle
+ * timestamp. Once the trigger fires, POST more entries are
+ * recorded and capture stops, so the ring holds up to
+ * 2^AW - 1 - POST entries from before the trigger, the
+ * trigger entry and POST after.
+ * One event is recorded per cycle (Wishbone, then IRQ, then
+ * pins); an event that loses that race sets LOST.
+ *
+ * Entry layout (three words):
+ * - DATA0 : Wishbone data, or the changed IRQ / pin bits
+ * - DATA1 : [31:28] type (1: Wishbone, 2: IRQ, 3: pins),
+ *           [27] WE, [23:16] IRQ or pin state,
+ *           [15:0] Wishbone address
+ * - DATA2 : timestamp (cycles since ARM)
+ *
+ * Registers (offsets from the trace block base):
+ * - 0x00 TRACE_CTRL   : [0] ARM (write 1: clear and start),
+ *                       [1] FORCE (trigger now),
+ *                       [5:4] trigger (0: address, 1: IRQ
+ *                       rising edge, 2: pin pattern),
+ *                       [10:8] event enable (WB, IRQ, pins)
+ * - 0x04 TRACE_TRIG   : [15:0] trigger value
+ * - 0x08 TRACE_MASK   : [15:0] trigger mask
+ * - 0x0C TRACE_POST   : entries recorded after the trigger,
+ *                       clamped to 2^AW - 1 so the trigger
+ *                       entry is never overwritten
+ * - 0x10 TRACE_STATUS : [0] ARMED, [1] TRIGGERED, [2] DONE,
+ *                       [3] WRAPPED, [4] LOST,
+ *                       [15:8] next write entry,
+ *                       [23:16] trigger entry
+ * - 0x14 TRACE_IDX    : entry selected for reading
+ * - 0x18 TRACE_DATA0
+ * - 0x1C TRACE_DATA1
+ * - 0x20 TRACE_DATA2  : reading advances TRACE_IDX
+ *
+ *-------------------------------------------------------------
+ */
+
+module trace_buffer #(
+    parameter AW = 5    // 2^AW entries, AW at most 7
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [5:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Observed Wishbone accesses (one-cycle strobe per completion)
+    input mon_wb,
+    input mon_we,
+    input [15:0] mon_addr,
+    input [31:0] mon_data,
+
+    // Observed interrupt lines and pins (clk domain)
+    input [2:0] mon_irq,
+    input [7:0] mon_pins,
+
+    // Data word of the entry at TRACE_IDX
+    output [31:0] la_data
+);
+
+    // Register addresses
+    localparam TRACE_CTRL   = 6'h00;
+    localparam TRACE_TRIG   = 6'h04;
+    localparam TRACE_MASK   = 6'h08;
+    localparam TRACE_POST   = 6'h0C;
+    localparam TRACE_STATUS = 6'h10;
+    localparam TRACE_IDX    = 6'h14;
+    localparam TRACE_DATA0  = 6'h18;
+    localparam TRACE_DATA1  = 6'h1C;
+    localparam TRACE_DATA2  = 6'h20;
+
+    // Trigger sources
+    localparam TRIG_ADDR = 2'd0;
+    localparam TRIG_IRQ  = 2'd1;
+    localparam TRIG_PINS = 2'd2;
+
+    // Entry types
+    localparam EV_WB   = 4'd1;
+    localparam EV_IRQ  = 4'd2;
+    localparam EV_PINS = 4'd3;
+
+    localparam DEPTH = 1 << AW;
+    localparam [AW:0] POST_MAX = DEPTH - 1;
+    localparam [AW:0] POST_RESET = DEPTH / 2;
+
+    // Configuration
+    reg [1:0] trig_src;
+    reg [2:0] ev_en;
+    reg [15:0] trig_value;
+    reg [15:0] trig_mask;
+    reg [AW:0] post;
+    reg [AW-1:0] rd_idx;
+
+    // Capture state
+    reg armed;
+    reg triggered;
+    reg done;
+    reg wrapped;
+    reg lost;
+    reg [AW-1:0] wr_ptr;
+    reg [AW-1:0] trig_ptr;
+    reg [AW:0] post_left;
+    reg [31:0] timestamp;
+    reg [2:0] irq_q;
+    reg [7:0] pins_q;
+
+    reg [31:0] mem_data [0:DEPTH-1];
+    reg [31:0] mem_info [0:DEPTH-1];
+    reg [31:0] mem_time [0:DEPTH-1];
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire arm_req = wb_cycle && wb_we && (wb_addr == TRACE_CTRL) && wb_data_in[0];
+    wire force_req = wb_cycle && wb_we && (wb_addr == TRACE_CTRL) && wb_data_in[1];
+
+    // Events
+    wire [2:0] irq_rise = mon_irq & ~irq_q;
+    wire [2:0] irq_change = mon_irq ^ irq_q;
+    wire [7:0] pins_change = mon_pins ^ pins_q;
+
+    wire ev_wb = ev_en[0] && mon_wb;
+    wire ev_irq = ev_en[1] && (irq_change != 3'h0);
+    wire ev_pins = ev_en[2] && (pins_change != 8'h0);
+
+    wire capturing = armed && !done;
+    wire record = capturing && (ev_wb || ev_irq || ev_pins);
+    wire drop = capturing && ((ev_wb && (ev_irq || ev_pins)) || (ev_irq && ev_pins));
+
+    wire [31:0] rec_data = ev_wb ? mon_data :
+                           ev_irq ? {29'h0, irq_change} : {24'h0, pins_change};
+    wire [31:0] rec_info = ev_wb ? {EV_WB, mon_we, 11'h0, mon_addr} :
+                           ev_irq ? {EV_IRQ, 4'h0, 5'h0, mon_irq, 16'h0} :
+                                    {EV_PINS, 4'h0, mon_pins, 16'h0};
+
+    // Trigger
+    wire trig_hit = (trig_src == TRIG_ADDR) ? (mon_wb && ((mon_addr & trig_mask) == (trig_value & trig_mask))) :
+                    (trig_src == TRIG_IRQ) ? ((irq_rise & trig_mask[2:0]) != 3'h0) :
+                    (trig_src == TRIG_PINS) ? ((mon_pins & trig_mask[7:0]) == (trig_value[7:0] & trig_mask[7:0])) :
+                    1'b0;
+    wire trig_fire = capturing && !triggered && (trig_hit || force_req);
+
+    assign la_data = mem_data[rd_idx];
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            trig_src <= TRIG_ADDR;
+            ev_en <= 3'h0;
+            trig_value <= 16'h0;
+            trig_mask <= 16'h0;
+            post <= POST_RESET;
+            rd_idx <= {AW{1'b0}};
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        TRACE_CTRL: begin
+                            trig_src <= wb_data_in[5:4];
+                            ev_en <= wb_data_in[10:8];
+                        end
+                        TRACE_TRIG: trig_value <= wb_data_in[15:0];
+                        TRACE_MASK: trig_mask <= wb_data_in[15:0];
+                        TRACE_POST: post <= (wb_data_in > POST_MAX) ? POST_MAX : wb_data_in[AW:0];
+                        TRACE_IDX: rd_idx <= wb_data_in[AW-1:0];
+                        default: ; // Status and data are read-only
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        TRACE_CTRL: wb_data_out <= {21'h0, ev_en, 2'h0, trig_src, 3'h0, armed};
+                        TRACE_TRIG: wb_data_out <= {16'h0, trig_value};
+                        TRACE_MASK: wb_data_out <= {16'h0, trig_mask};
+                        TRACE_POST: wb_data_out <= {{(31-AW){1'b0}}, post};
+                        TRACE_STATUS: wb_data_out <= {8'h0, {(8-AW){1'b0}}, trig_ptr,
+                                                      {(8-AW){1'b0}}, wr_ptr,
+                                                      3'h0, lost, wrapped, done, triggered, armed};
+                        TRACE_IDX: wb_data_out <= {{(32-AW){1'b0}}, rd_idx};
+                        TRACE_DATA0: wb_data_out <= mem_data[rd_idx];
+                        TRACE_DATA1: wb_data_out <= mem_info[rd_idx];
+                        TRACE_DATA2: begin
+                            wb_data_out <= mem_time[rd_idx];
+                            rd_idx <= rd_idx + 1'b1;
+                        end
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // Capture
+    always @(posedge clk) begin
+        if (rst) begin
+            armed <= 1'b0;
+            triggered <= 1'b0;
+            done <= 1'b0;
+            wrapped <= 1'b0;
+            lost <= 1'b0;
+            wr_ptr <= {AW{1'b0}};
+            trig_ptr <= {AW{1'b0}};
+            post_left <= {(AW+1){1'b0}};
+            timestamp <= 32'h0;
+            irq_q <= 3'h0;
+            pins_q <= 8'h0;
+        end else begin
+            irq_q <= mon_irq;
+            pins_q <= mon_pins;
+            timestamp <= timestamp + 32'h1;
+
+            if (arm_req) begin
+                armed <= 1'b1;
+                triggered <= 1'b0;
+                done <= 1'b0;
+                wrapped <= 1'b0;
+                lost <= 1'b0;
+                wr_ptr <= {AW{1'b0}};
+                timestamp <= 32'h0;
+            end else if (capturing) begin
+                if (record) begin
+                    wr_ptr <= wr_ptr + 1'b1;
+                    if (&wr_ptr)
+                        wrapped <= 1'b1;
+                end
+                if (drop)
+                    lost <= 1'b1;
+
+                if (trig_fire) begin
+                    triggered <= 1'b1;
+                    trig_ptr <= wr_ptr;
+                    post_left <= post;
+                    if (post == {(AW+1){1'b0}})
+                        done <= 1'b1;
+                end else if (triggered && record) begin
+                    post_left <= post_left - 1'b1;
+                    if (post_left == 1)
+                        done <= 1'b1;
+                end
+            end
+        end
+    end
+
+    // Trace RAM is not reset
+    always @(posedge clk) begin
+        if (record && !arm_req) begin
+            mem_data[wr_ptr] <= rec_data;
+            mem_info[wr_ptr] <= rec_info;
+            mem_time[wr_ptr] <= timestamp;
+        end
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * uart_array
+ *
+ * N CF_UART_WB channels on the serial clock, each behind its
+ * own Wishbone CDC bridge. The parent decodes the channel
+ * windows and passes a one-hot channel select with the shared
+ * request; s_addr is already window-relative (IP offsets).
+ *
+ * The channel interrupts are synchronised into the bus clock
+ * domain and returned as a vector, bit i for channel i.
+ *
+ * Each core runs on ser_clk through one clock gate. For channel
+ * 0 the gate also takes ch0_en from the fractional baud
+ * generator; the bridges stay on ser_clk. CF_UART_WB pushes and
+ * pops on the core edge after it raises ack_o, so a bridge only
+ * takes the ack when src_en lets the next edge through and the
+ * request is still up for it.
+ *
+ * With cg_enable set each channel's core clock also stops once
+ * the channel is idle: no register access in flight, RX high
+ * and TX unchanged for the idle time. An access, RX going low or
+ * a TX edge restarts it in the same cycle and holds it open for
+ * 16 bit times of core pulses, 128 * (PR + 1), which covers the
+ * longest frame CF_UART sends or receives. PR is snooped from
+ * register writes to the channel.
+ *
+ *-------------------------------------------------------------
+ */
+
+module uart_array #(
+    parameter N = 2
+)(
+`ifdef USE_POWER_PINS
+    inout vccd1,
+    inout vssd1,
+`endif
+
+    // Local bus side
+    input clk,
+    input rst,
+    input s_valid,
+    input [N-1:0] s_chan,
+    input s_we,
+    input [3:0] s_sel,
+    input [15:0] s_addr,
+    input [31:0] s_data_in,
+    output reg [31:0] s_data_out,
+    output s_ack,
+
+    // Serial side
+    input ser_clk,
+    input ser_rst,
+    input ch0_en,
+    input cg_enable,
+    input [3:0] cg_idle,
+    input [N-1:0] rx,
+    output [N-1:0] tx,
+    output [N-1:0] clk_stopped,
+
+    // Per-channel interrupts (clk domain)
+    output [N-1:0] irq
+);
+
+    // CF_UART prescaler register
+    localparam PR_OFFSET = 16'h0008;
+
+    wire [32*N-1:0] ch_data_out;
+    wire [N-1:0] ch_ack;
+    wire [N-1:0] ch_irq_ser;
+
+    genvar i;
+    generate
+        for (i = 0; i < N; i = i + 1) begin : g_uart
+            wire ip_valid;
+            wire ip_we;
+            wire [3:0] ip_sel;
+            wire [15:0] ip_addr;
+            wire [31:0] ip_data_in;
+            wire [31:0] ip_data_out;
+            wire ip_ack;
+            wire src_en;
+            wire core_clk;
+
+            if (i == 0) begin : g_ch0_en
+                assign src_en = ch0_en;
+            end else begin : g_ser_clk
+                assign src_en = 1'b1;
+            end
+
+            // Idle clock gating
+            wire rx_s;
+            reg tx_q;
+            reg [15:0] pr;
+
+            cdc_sync #(
+                .WIDTH(1)
+            ) rx_sync (
+                .clk(ser_clk),
+                .rst(ser_rst),
+                .d(rx[i]),
+                .q(rx_s)
+            );
+
+            always @(posedge ser_clk) begin
+                if (ser_rst) begin
+                    tx_q <= 1'b1;
+                    pr <= 16'h0;
+                end else begin
+                    tx_q <= tx[i];
+                    if (ip_valid && ip_we && ip_addr == PR_OFFSET)
+                        pr <= ip_data_in[15:0];
+                end
+            end
+
+            idle_clk_gate cg (
+`ifdef USE_POWER_PINS
+                .vccd1(vccd1),
+                .vssd1(vssd1),
+`endif
+                .clk(ser_clk),
+                .rst(ser_rst),
+                .src_en(src_en),
+                .enable(cg_enable),
+                .idle_sel(cg_idle),
+                .wake(ip_valid || !rx_s || (tx[i] != tx_q)),
+                .hold_len({{1'b0, pr} + 17'h1, 7'h0}),
+                .gclk(core_clk),
+                .stopped(clk_stopped[i])
+            );
+
+            wb_cdc_bridge cdc (
+                .clk_a(clk),
+                .rst_a(rst),
+                .s_valid(s_valid && s_chan[i]),
+                .s_we(s_we),
+                .s_sel(s_sel),
+                .s_addr(s_addr),
+                .s_data_in(s_data_in),
+                .s_data_out(ch_data_out[32*i +: 32]),
+                .s_ack(ch_ack[i]),
+                .clk_b(ser_clk),
+                .rst_b(ser_rst),
+                .m_valid(ip_valid),
+                .m_we(ip_we),
+                .m_sel(ip_sel),
+                .m_addr(ip_addr),
+                .m_data_out(ip_data_in),
+                .m_data_in(ip_data_out),
+                .m_ack(ip_ack && src_en)
+            );
+
+            CF_UART_WB #(
+                .SC(8),
+                .MDW(9),
+                .GFLEN(8),
+                .FAW(4)
+            ) uart_inst (
+                .clk_i(core_clk),
+                .rst_i(ser_rst),
+                .adr_i({16'h0, ip_addr}),
+                .dat_i(ip_data_in),
+                .dat_o(ip_data_out),
+                .sel_i(ip_sel),
+                .cyc_i(ip_valid),
+                .stb_i(ip_valid),
+                .ack_o(ip_ack),
+                .we_i(ip_we),
+                .IRQ(ch_irq_ser[i]),
+                .rx(rx[i]),
+                .tx(tx[i])
+            );
+        end
+    endgenerate
+
+    // Read data from the selected channel
+    integer j;
+    always @(*) begin
+        s_data_out = 32'h0;
+        for (j = 0; j < N; j = j + 1)
+            if (s_chan[j])
+                s_data_out = ch_data_out[32*j +: 32];
+    end
+
+    assign s_ack = |(ch_ack & s_chan);
+
+    cdc_sync #(
+        .WIDTH(N)
+    ) irq_sync (
+        .clk(clk),
+        .rst(rst),
+        .d(ch_irq_ser),
+        .q(irq)
+    );
+
+endmodule
+
+`default_nettype wire
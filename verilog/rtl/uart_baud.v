@@ -0,0 +1,258 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * uart_baud
+ *
+ * Fractional baud generator and auto-baud detector for UART
+ * channel 0, in the serial clock domain.
+ *
+ * CF_UART only divides by an integer prescaler, so instead of
+ * changing its divider the core clock itself is thinned: a
+ * 24-bit phase accumulator raises core_en for (FRAC + 1) of
+ * every 2^24 clock pulses, and channel 0's clock gate in
+ * uart_array passes only those. With PR = 0 the bit rate
+ * is ser_clk * (FRAC + 1) / 2^27, exact to 24 bits on average
+ * and within one ser_clk period per sample tick, up to
+ * ser_clk / 8 with FRAC = 0xFFFFFF.
+ *
+ * Auto-baud times eight bit periods of a 0x55 ('U') from the
+ * peer: from the start bit's falling edge to the fifth falling
+ * edge on RX. FRAC is then set to 2^30 / cycles - 1 and FRAC_EN
+ * is turned on. PR must be 0 while auto-baud is used. A
+ * BAUD_CTRL write with AUTO = 0 aborts a run in any state and
+ * takes its FRAC_EN; DONE and ERROR stay clear.
+ *
+ * Registers (offsets from the baud block base):
+ * - 0x00 BAUD_CTRL   : [0] FRAC_EN, [1] AUTO (write 1 to start)
+ * - 0x04 BAUD_FRAC   : [23:0] core clock pulses per 2^24, minus 1
+ * - 0x08 BAUD_STATUS : [0] BUSY, [1] DONE, [2] ERROR (too fast,
+ *                      or no start bit or next edge within 2^24
+ *                      cycles)
+ * - 0x0C BAUD_MEAS   : [23:0] ser_clk cycles over eight bits
+ *
+ *-------------------------------------------------------------
+ */
+
+module uart_baud (
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [4:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // RX pad (asynchronous)
+    input rx,
+
+    // Core clock enable, one clk cycle ahead of the pulse it passes
+    output reg core_en
+);
+
+    // Register addresses
+    localparam BAUD_CTRL   = 5'h00;
+    localparam BAUD_FRAC   = 5'h04;
+    localparam BAUD_STATUS = 5'h08;
+    localparam BAUD_MEAS   = 5'h0C;
+
+    // Auto-baud states
+    localparam AB_IDLE = 2'd0;
+    localparam AB_WAIT = 2'd1;    // waiting for the start bit
+    localparam AB_TIME = 2'd2;    // counting to the fifth falling edge
+    localparam AB_DIV  = 2'd3;    // computing FRAC
+
+    reg frac_en;
+    reg [23:0] frac;
+    reg done;
+    reg error;
+    reg [23:0] meas;
+
+    reg [1:0] ab_state;
+    reg [2:0] edges;
+    reg [23:0] timer;
+    reg [4:0] div_cnt;
+    reg [30:0] div_rem;
+    reg [23:0] div_quo;
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire auto_req = wb_cycle && wb_we && (wb_addr == BAUD_CTRL) && wb_data_in[1];
+    wire abort_req = wb_cycle && wb_we && (wb_addr == BAUD_CTRL) && !wb_data_in[1];
+    wire busy = (ab_state != AB_IDLE);
+
+    // Register interface
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (!wb_we) begin
+                    case (wb_addr)
+                        BAUD_CTRL: wb_data_out <= {30'h0, busy, frac_en};
+                        BAUD_FRAC: wb_data_out <= {8'h0, frac};
+                        BAUD_STATUS: wb_data_out <= {29'h0, error, done, busy};
+                        BAUD_MEAS: wb_data_out <= {8'h0, meas};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    // RX edge detection
+    wire rx_s;
+    reg rx_q;
+
+    cdc_sync #(
+        .WIDTH(1)
+    ) rx_sync (
+        .clk(clk),
+        .rst(rst),
+        .d(rx),
+        .q(rx_s)
+    );
+
+    wire rx_fall = rx_q && !rx_s;
+
+    // Configuration and auto-baud. FRAC and FRAC_EN are written by
+    // firmware or by the detector, never both in one cycle: writes
+    // other than an abort are ignored while it is busy, and an abort's
+    // FRAC_EN wins over the detector's in the same cycle.
+    always @(posedge clk) begin
+        if (rst) begin
+            rx_q <= 1'b0;
+            frac_en <= 1'b0;
+            frac <= 24'hFFFFFF;
+            done <= 1'b0;
+            error <= 1'b0;
+            meas <= 24'h0;
+            ab_state <= AB_IDLE;
+            edges <= 3'h0;
+            timer <= 24'h0;
+            div_cnt <= 5'h0;
+            div_rem <= 31'h0;
+            div_quo <= 24'h0;
+        end else begin
+            rx_q <= rx_s;
+
+            case (ab_state)
+                AB_IDLE: begin
+                    if (wb_cycle && wb_we) begin
+                        case (wb_addr)
+                            BAUD_CTRL: frac_en <= wb_data_in[0];
+                            BAUD_FRAC: frac <= wb_data_in[23:0];
+                            default: ;
+                        endcase
+                    end
+                    if (auto_req) begin
+                        done <= 1'b0;
+                        error <= 1'b0;
+                        edges <= 3'h0;
+                        timer <= 24'h0;
+                        ab_state <= AB_WAIT;
+                    end
+                end
+
+                AB_WAIT: begin
+                    timer <= timer + 24'h1;
+                    if (rx_fall) begin
+                        edges <= 3'h1;
+                        timer <= 24'h0;
+                        ab_state <= AB_TIME;
+                    end else if (timer == 24'hFFFFFF) begin
+                        error <= 1'b1;
+                        ab_state <= AB_IDLE;
+                    end
+                end
+
+                AB_TIME: begin
+                    timer <= timer + 24'h1;
+                    if (rx_fall) begin
+                        edges <= edges + 3'h1;
+                        if (edges == 3'h4) begin
+                            meas <= timer + 24'h1;
+                            ab_state <= AB_DIV;
+                            div_cnt <= 5'd0;
+                            div_rem <= 31'h0;
+                            div_quo <= 24'h0;
+                        end
+                    end else if (timer == 24'hFFFFFF) begin
+                        error <= 1'b1;
+                        ab_state <= AB_IDLE;
+                    end
+                end
+
+                AB_DIV: begin
+                    // Restoring division of 2^30 by meas, one quotient
+                    // bit per cycle from bit 30 down
+                    if (meas < 24'd64) begin
+                        error <= 1'b1;
+                        ab_state <= AB_IDLE;
+                    end else if (div_cnt == 5'd31) begin
+                        frac <= div_quo - 24'h1;
+                        frac_en <= 1'b1;
+                        done <= 1'b1;
+                        ab_state <= AB_IDLE;
+                    end else begin
+                        div_cnt <= div_cnt + 5'd1;
+                        if ({div_rem[29:0], (div_cnt == 5'd0)} >= {7'h0, meas}) begin
+                            div_rem <= {div_rem[29:0], (div_cnt == 5'd0)} - {7'h0, meas};
+                            div_quo <= {div_quo[22:0], 1'b1};
+                        end else begin
+                            div_rem <= {div_rem[29:0], (div_cnt == 5'd0)};
+                            div_quo <= {div_quo[22:0], 1'b0};
+                        end
+                    end
+                end
+            endcase
+
+            if (busy && abort_req) begin
+                frac_en <= wb_data_in[0];
+                done <= 1'b0;
+                error <= 1'b0;
+                ab_state <= AB_IDLE;
+            end
+        end
+    end
+
+    // Phase accumulator. core_en stays high while FRAC_EN is low so
+    // the core sees the plain serial clock.
+    reg [23:0] phase;
+    wire [24:0] phase_next = {1'b0, phase} + {1'b0, frac} + 25'h1;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            phase <= 24'h0;
+            core_en <= 1'b1;
+        end else begin
+            phase <= phase_next[23:0];
+            core_en <= !frac_en || phase_next[24];
+        end
+    end
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,579 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * uart_framer
+ *
+ * SLIP or COBS framing for UART channel 0. Firmware writes raw
+ * frame bytes and reads back decoded frames; while enabled the
+ * framer masters the local bus like stream_bridge, feeding the
+ * encoded stream into the UART TX FIFO and decoding everything
+ * the UART receives.
+ *
+ * TX: each TXDATA write carries one payload byte, with END set
+ * on the last byte of the frame. SLIP escapes 0xC0/0xDB and
+ * closes the frame with 0xC0. COBS closes a block at every zero,
+ * at 254 bytes and at END, and ends the frame with 0x00. A COBS
+ * block must be complete before its code byte can be sent, so
+ * the TX FIFO holds 2^TX_AW bytes (254 or more for COBS).
+ *
+ * RX: decoded bytes go to the RX FIFO in order. When a delimiter
+ * ends a non-empty frame its length is queued in RXLEN and the
+ * frame interrupt is raised; a bad escape or a COBS block cut
+ * short marks the frame with ERROR. Bytes are only taken from
+ * the UART while both RX queues have room, so frames longer
+ * than the RX FIFO have to be drained as they arrive.
+ *
+ * Registers (offsets from the framer block base):
+ * - 0x00 FRM_CTRL   : [0] EN, [1] COBS (0: SLIP),
+ *                     [4] frame interrupt enable
+ * - 0x04 FRM_TXDATA : [7:0] byte, [8] END
+ * - 0x08 FRM_RXDATA : [7:0] decoded byte (read pops)
+ * - 0x0C FRM_RXLEN  : oldest completed frame (read pops):
+ *                     [15:0] length, [30] ERROR, [31] VALID
+ * - 0x10 FRM_STATUS : [8:0] TX level, [9] TX_FULL,
+ *                     [10] TX_IDLE, [11] TX_OVERFLOW,
+ *                     [23:16] RX level, [24] frame waiting
+ *                     in RXLEN (write 1 to clear [11])
+ *
+ * A TXDATA write while TX_FULL is set is acknowledged but the
+ * byte is dropped and TX_OVERFLOW latches, so the frame must be
+ * resent. The write is not stalled: with EN clear the queue never
+ * drains and a stall would hang the Wishbone host.
+ *
+ * Change COBS only while EN is clear and TX_IDLE is set.
+ *
+ *-------------------------------------------------------------
+ */
+
+module uart_framer #(
+    parameter TX_AW = 8,    // at most 8
+    parameter RX_AW = 5,    // at most 7
+    parameter FIFO_DEPTH = 16,  // UART FIFO depth
+    parameter UART_WIN = 4'h1
+)(
+    input clk,
+    input rst,
+
+    // Register interface
+    input wb_valid,
+    input wb_we,
+    input [4:0] wb_addr,
+    input [31:0] wb_data_in,
+    output reg [31:0] wb_data_out,
+    output reg wb_ack,
+
+    // Local bus master
+    output reg m_valid,
+    output reg m_we,
+    output [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output reg [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack,
+
+    output irq
+);
+
+    // Register addresses
+    localparam FRM_CTRL   = 5'h00;
+    localparam FRM_TXDATA = 5'h04;
+    localparam FRM_RXDATA = 5'h08;
+    localparam FRM_RXLEN  = 5'h0C;
+    localparam FRM_STATUS = 5'h10;
+
+    // Register offsets inside the UART window
+    localparam RXDATA_OFFSET = 12'h000;
+    localparam TXDATA_OFFSET = 12'h004;
+    localparam RX_LEVEL_OFFSET = 12'hE00;
+    localparam TX_LEVEL_OFFSET = 12'hE10;
+
+    // SLIP specials
+    localparam SLIP_END     = 8'hC0;
+    localparam SLIP_ESC     = 8'hDB;
+    localparam SLIP_ESC_END = 8'hDC;
+    localparam SLIP_ESC_ESC = 8'hDD;
+
+    reg enable;
+    reg cobs;
+    reg irq_en;
+    reg tx_overflow;
+
+    wire wb_cycle = wb_valid && !wb_ack;
+    wire tx_write = wb_cycle && wb_we && (wb_addr == FRM_TXDATA);
+    wire [7:0] tx_byte = wb_data_in[7:0];
+    wire tx_end = wb_data_in[8];
+
+    //---------------------------------------------------------
+    // TX queues: payload bytes ({END, byte}; COBS leaves zeros
+    // out) and, for COBS, one {last, code} entry per closed block
+    //---------------------------------------------------------
+    reg data_wr;
+    reg [8:0] data_wr_data;
+    wire data_rd;
+    wire [8:0] data_rd_data;
+    wire data_empty, data_full;
+    wire [TX_AW:0] data_level;
+
+    reg code_wr;
+    reg [8:0] code_wr_data;
+    wire code_rd;
+    wire [8:0] code_rd_data;
+    wire code_empty, code_full;
+    wire [4:0] code_level;
+
+    qspi_fifo #(
+        .DW(9),
+        .AW(TX_AW)
+    ) tx_data_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(data_wr),
+        .wr_data(data_wr_data),
+        .rd(data_rd),
+        .rd_data(data_rd_data),
+        .empty(data_empty),
+        .full(data_full),
+        .level(data_level)
+    );
+
+    qspi_fifo #(
+        .DW(9),
+        .AW(4)
+    ) tx_code_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(code_wr),
+        .wr_data(code_wr_data),
+        .rd(code_rd),
+        .rd_data(code_rd_data),
+        .empty(code_empty),
+        .full(code_full),
+        .level(code_level)
+    );
+
+    // A zero with END needs two code entries, so keep one spare
+    wire tx_full = data_full || (code_level >= 5'd15);
+
+    // COBS block assembly
+    reg [7:0] run;
+    reg cobs_tail;  // final empty block after a trailing zero
+
+    always @(posedge clk) begin
+        if (rst) begin
+            data_wr <= 1'b0;
+            data_wr_data <= 9'h0;
+            code_wr <= 1'b0;
+            code_wr_data <= 9'h0;
+            run <= 8'h0;
+            cobs_tail <= 1'b0;
+        end else begin
+            data_wr <= 1'b0;
+            code_wr <= 1'b0;
+
+            if (cobs_tail) begin
+                code_wr <= 1'b1;
+                code_wr_data <= {1'b1, 8'h01};
+                cobs_tail <= 1'b0;
+            end else if (tx_write && !tx_full) begin
+                if (!cobs) begin
+                    data_wr <= 1'b1;
+                    data_wr_data <= {tx_end, tx_byte};
+                end else if (tx_byte == 8'h00) begin
+                    code_wr <= 1'b1;
+                    code_wr_data <= {1'b0, run + 8'h1};
+                    run <= 8'h0;
+                    cobs_tail <= tx_end;
+                end else begin
+                    data_wr <= 1'b1;
+                    data_wr_data <= {1'b0, tx_byte};
+                    if (run == 8'd253 || tx_end) begin
+                        code_wr <= 1'b1;
+                        code_wr_data <= {tx_end, run + 8'h2};
+                        run <= 8'h0;
+                    end else begin
+                        run <= run + 8'h1;
+                    end
+                end
+            end
+        end
+    end
+
+    //---------------------------------------------------------
+    // Encoder: presents the next wire byte on enc_byte while
+    // enc_avail, and moves on when enc_adv is pulsed
+    //---------------------------------------------------------
+    localparam E_NEXT  = 2'd0;  // COBS code byte / SLIP data byte
+    localparam E_DATA  = 2'd1;  // COBS block bytes
+    localparam E_ESC   = 2'd2;  // SLIP second escape byte
+    localparam E_DELIM = 2'd3;
+
+    reg [1:0] enc_state;
+    reg [7:0] enc_left;
+    reg enc_last;
+    reg enc_adv;
+
+    wire [7:0] slip_byte = data_rd_data[7:0];
+    wire slip_special = (slip_byte == SLIP_END) || (slip_byte == SLIP_ESC);
+
+    wire enc_avail = (enc_state == E_DELIM) || (enc_state == E_ESC) ||
+                     (enc_state == E_DATA) ||
+                     (cobs ? !code_empty : !data_empty);
+
+    wire [7:0] enc_byte = (enc_state == E_DELIM) ? (cobs ? 8'h00 : SLIP_END) :
+                          (enc_state == E_ESC) ? ((slip_byte == SLIP_END) ? SLIP_ESC_END : SLIP_ESC_ESC) :
+                          (enc_state == E_DATA) ? data_rd_data[7:0] :
+                          cobs ? code_rd_data[7:0] :
+                          slip_special ? SLIP_ESC : slip_byte;
+
+    assign code_rd = enc_adv && cobs && (enc_state == E_NEXT);
+    assign data_rd = enc_adv && ((enc_state == E_DATA) || (enc_state == E_ESC) ||
+                                 (!cobs && enc_state == E_NEXT && !slip_special));
+
+    wire tx_idle = data_empty && code_empty && (enc_state == E_NEXT) && !cobs_tail;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            enc_state <= E_NEXT;
+            enc_left <= 8'h0;
+            enc_last <= 1'b0;
+        end else if (enc_adv) begin
+            case (enc_state)
+                E_NEXT: begin
+                    if (cobs) begin
+                        enc_left <= code_rd_data[7:0] - 8'h1;
+                        enc_last <= code_rd_data[8];
+                        if (code_rd_data[7:0] != 8'h01)
+                            enc_state <= E_DATA;
+                        else if (code_rd_data[8])
+                            enc_state <= E_DELIM;
+                    end else if (slip_special) begin
+                        enc_state <= E_ESC;
+                    end else if (data_rd_data[8]) begin
+                        enc_state <= E_DELIM;
+                    end
+                end
+
+                E_DATA: begin
+                    enc_left <= enc_left - 8'h1;
+                    if (enc_left == 8'h1)
+                        enc_state <= enc_last ? E_DELIM : E_NEXT;
+                end
+
+                E_ESC: enc_state <= data_rd_data[8] ? E_DELIM : E_NEXT;
+
+                default: enc_state <= E_NEXT;
+            endcase
+        end
+    end
+
+    //---------------------------------------------------------
+    // RX queues and decoder
+    //---------------------------------------------------------
+    reg rx_wr;
+    reg [7:0] rx_wr_data;
+    wire rx_rd = wb_cycle && !wb_we && (wb_addr == FRM_RXDATA);
+    wire [7:0] rx_rd_data;
+    wire rx_empty, rx_full;
+    wire [RX_AW:0] rx_level;
+
+    reg len_wr;
+    reg [16:0] len_wr_data;
+    wire len_rd = wb_cycle && !wb_we && (wb_addr == FRM_RXLEN);
+    wire [16:0] len_rd_data;
+    wire len_empty, len_full;
+    wire [2:0] len_level;
+
+    qspi_fifo #(
+        .DW(8),
+        .AW(RX_AW)
+    ) rx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(rx_wr),
+        .wr_data(rx_wr_data),
+        .rd(rx_rd),
+        .rd_data(rx_rd_data),
+        .empty(rx_empty),
+        .full(rx_full),
+        .level(rx_level)
+    );
+
+    qspi_fifo #(
+        .DW(17),
+        .AW(2)
+    ) len_fifo (
+        .clk(clk),
+        .rst(rst),
+        .wr(len_wr),
+        .wr_data(len_wr_data),
+        .rd(len_rd),
+        .rd_data(len_rd_data),
+        .empty(len_empty),
+        .full(len_full),
+        .level(len_level)
+    );
+
+    // Each received byte pushes at most one decoded byte and one
+    // length, so one free slot in each is enough to take it
+    wire dec_room = !rx_full && !len_full;
+
+    reg dec_in;
+    reg [7:0] dec_byte;
+    reg [15:0] dec_len;
+    reg dec_err;
+    reg dec_esc;            // SLIP: escape seen
+    reg [7:0] dec_left;     // COBS: block bytes still to come
+    reg dec_ff;             // COBS: current block has no implied zero
+    reg dec_zero;           // COBS: implied zero owed before the next block
+
+    always @(posedge clk) begin
+        if (rst) begin
+            rx_wr <= 1'b0;
+            rx_wr_data <= 8'h0;
+            len_wr <= 1'b0;
+            len_wr_data <= 17'h0;
+            dec_len <= 16'h0;
+            dec_err <= 1'b0;
+            dec_esc <= 1'b0;
+            dec_left <= 8'h0;
+            dec_ff <= 1'b0;
+            dec_zero <= 1'b0;
+        end else begin
+            rx_wr <= 1'b0;
+            len_wr <= 1'b0;
+
+            if (dec_in) begin
+                if (!cobs) begin
+                    if (dec_byte == SLIP_END) begin
+                        if (dec_len != 16'h0 || dec_err) begin
+                            len_wr <= 1'b1;
+                            len_wr_data <= {dec_err, dec_len};
+                        end
+                        dec_len <= 16'h0;
+                        dec_err <= 1'b0;
+                        dec_esc <= 1'b0;
+                    end else if (dec_esc) begin
+                        dec_esc <= 1'b0;
+                        if (dec_byte == SLIP_ESC_END || dec_byte == SLIP_ESC_ESC) begin
+                            rx_wr <= 1'b1;
+                            rx_wr_data <= (dec_byte == SLIP_ESC_END) ? SLIP_END : SLIP_ESC;
+                            dec_len <= dec_len + 16'h1;
+                        end else begin
+                            dec_err <= 1'b1;
+                        end
+                    end else if (dec_byte == SLIP_ESC) begin
+                        dec_esc <= 1'b1;
+                    end else begin
+                        rx_wr <= 1'b1;
+                        rx_wr_data <= dec_byte;
+                        dec_len <= dec_len + 16'h1;
+                    end
+                end else begin
+                    if (dec_byte == 8'h00) begin
+                        // The zero owed by the last block is dropped
+                        if (dec_len != 16'h0 || dec_err || dec_left != 8'h0) begin
+                            len_wr <= 1'b1;
+                            len_wr_data <= {dec_err || (dec_left != 8'h0), dec_len};
+                        end
+                        dec_len <= 16'h0;
+                        dec_err <= 1'b0;
+                        dec_left <= 8'h0;
+                        dec_zero <= 1'b0;
+                    end else if (dec_left == 8'h0) begin
+                        // Code byte
+                        if (dec_zero) begin
+                            rx_wr <= 1'b1;
+                            rx_wr_data <= 8'h00;
+                            dec_len <= dec_len + 16'h1;
+                        end
+                        dec_left <= dec_byte - 8'h1;
+                        dec_ff <= (dec_byte == 8'hFF);
+                        dec_zero <= (dec_byte == 8'h01);
+                    end else begin
+                        rx_wr <= 1'b1;
+                        rx_wr_data <= dec_byte;
+                        dec_len <= dec_len + 16'h1;
+                        dec_left <= dec_left - 8'h1;
+                        if (dec_left == 8'h1)
+                            dec_zero <= !dec_ff;
+                    end
+                end
+            end
+        end
+    end
+
+    //---------------------------------------------------------
+    // Local bus master: alternates between pushing encoded bytes
+    // into the UART TX FIFO and pulling received bytes through
+    // the decoder, one FIFO level read per burst
+    //---------------------------------------------------------
+    localparam S_IDLE     = 3'd0;
+    localparam S_TX_LEVEL = 3'd1;
+    localparam S_TX_WRITE = 3'd2;
+    localparam S_RX_LEVEL = 3'd3;
+    localparam S_RX_READ  = 3'd4;
+
+    reg [2:0] state;
+    reg [15:0] count;
+
+    wire [15:0] level = m_data_in[15:0];
+    // Room a write can use; one entry stays free
+    localparam [15:0] ROOM_MAX = FIFO_DEPTH - 1;
+    wire [15:0] room = (level < ROOM_MAX) ? (ROOM_MAX - level) : 16'h0;
+
+    assign m_sel = 4'hF;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            state <= S_IDLE;
+            count <= 16'h0;
+            m_valid <= 1'b0;
+            m_we <= 1'b0;
+            m_addr <= 16'h0;
+            m_data_out <= 32'h0;
+            enc_adv <= 1'b0;
+            dec_in <= 1'b0;
+            dec_byte <= 8'h0;
+        end else begin
+            enc_adv <= 1'b0;
+            dec_in <= 1'b0;
+
+            case (state)
+                S_IDLE: begin
+                    if (enable)
+                        state <= enc_avail ? S_TX_LEVEL : S_RX_LEVEL;
+                end
+
+                S_TX_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {UART_WIN, TX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        count <= room;
+                        state <= (room != 16'h0) ? S_TX_WRITE : S_RX_LEVEL;
+                    end
+                end
+
+                S_TX_WRITE: begin
+                    if (!m_valid && !enc_adv) begin
+                        if (count == 16'h0 || !enc_avail) begin
+                            state <= S_RX_LEVEL;
+                        end else begin
+                            m_valid <= 1'b1;
+                            m_we <= 1'b1;
+                            m_addr <= {UART_WIN, TXDATA_OFFSET};
+                            m_data_out <= {24'h0, enc_byte};
+                        end
+                    end else if (m_valid && m_ack) begin
+                        m_valid <= 1'b0;
+                        m_we <= 1'b0;
+                        enc_adv <= 1'b1;
+                        count <= count - 16'h1;
+                    end
+                end
+
+                S_RX_LEVEL: begin
+                    if (!m_valid) begin
+                        m_valid <= 1'b1;
+                        m_we <= 1'b0;
+                        m_addr <= {UART_WIN, RX_LEVEL_OFFSET};
+                    end else if (m_ack) begin
+                        m_valid <= 1'b0;
+                        count <= level;
+                        state <= (level != 16'h0) ? S_RX_READ : S_IDLE;
+                    end
+                end
+
+                S_RX_READ: begin
+                    if (!m_valid && !dec_in && !rx_wr && !len_wr) begin
+                        if (count == 16'h0 || !dec_room) begin
+                            state <= S_IDLE;
+                        end else begin
+                            m_valid <= 1'b1;
+                            m_we <= 1'b0;
+                            m_addr <= {UART_WIN, RXDATA_OFFSET};
+                        end
+                    end else if (m_valid && m_ack) begin
+                        m_valid <= 1'b0;
+                        dec_in <= 1'b1;
+                        dec_byte <= m_data_in[7:0];
+                        count <= count - 16'h1;
+                    end
+                end
+
+                default: state <= S_IDLE;
+            endcase
+        end
+    end
+
+    //---------------------------------------------------------
+    // Register interface
+    //---------------------------------------------------------
+    wire [8:0] tx_level9 = data_level;
+    wire [7:0] rx_level8 = rx_level;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            wb_ack <= 1'b0;
+            wb_data_out <= 32'h0;
+            enable <= 1'b0;
+            cobs <= 1'b0;
+            irq_en <= 1'b0;
+            tx_overflow <= 1'b0;
+        end else begin
+            wb_ack <= 1'b0;
+
+            if (tx_write && tx_full)
+                tx_overflow <= 1'b1;
+
+            if (wb_cycle) begin
+                wb_ack <= 1'b1;
+
+                if (wb_we) begin
+                    case (wb_addr)
+                        FRM_CTRL: begin
+                            enable <= wb_data_in[0];
+                            cobs <= wb_data_in[1];
+                            irq_en <= wb_data_in[4];
+                        end
+                        FRM_STATUS: if (wb_data_in[11]) tx_overflow <= 1'b0;
+                        default: ; // TXDATA is handled with the TX queues
+                    endcase
+                end else begin
+                    case (wb_addr)
+                        FRM_CTRL: wb_data_out <= {27'h0, irq_en, 2'h0, cobs, enable};
+                        FRM_RXDATA: wb_data_out <= {24'h0, rx_rd_data};
+                        FRM_RXLEN: wb_data_out <= {!len_empty, len_rd_data[16] && !len_empty, 14'h0,
+                                                   len_empty ? 16'h0 : len_rd_data[15:0]};
+                        FRM_STATUS: wb_data_out <= {7'h0, !len_empty, rx_level8,
+                                                    4'h0, tx_overflow, tx_idle, tx_full, tx_level9};
+                        default: wb_data_out <= 32'h0;
+                    endcase
+                end
+            end
+        end
+    end
+
+    assign irq = irq_en && !len_empty;
+
+endmodule
+
+`default_nettype wire
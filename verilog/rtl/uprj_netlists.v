@@ -22,7 +22,28 @@
     `default_nettype wire
     `include "gl/user_project_wrapper.v"
     `include "gl/user_proj_example.v"
+`elsif GL_UPRJ
+    // RTL wrapper around the user_proj_example netlist, defined by
+    // includes.rtl.caravel_user_project_gl_uprj_sdf (SIM=GL_UPRJ_SDF)
+    `default_nettype wire
+    `include "user_project_wrapper.v"
+    `include "gl/user_proj_example.v"
 `else
     `include "user_project_wrapper.v"
     `include "user_proj_example.v"
+    `include "wb_frontend.v"
+    `include "wb_cdc_bridge.v"
+    `include "dma_engine.v"
+    `include "stream_bridge.v"
+    `include "qspi_master.v"
+    `include "uart_array.v"
+    `include "irq_coalescer.v"
+    `include "trace_buffer.v"
+    `include "spi_slave.v"
+    `include "uart_baud.v"
+    `include "crc_engine.v"
+    `include "uart_framer.v"
+    `include "status_poller.v"
+    `include "idle_clk_gate.v"
+    `include "la_mailbox.v"
 `endif
\ No newline at end of file
@@ -25,15 +25,46 @@
  * Features:
  * - SPI master interface with GPIO connections
  * - UART interface with GPIO connections
- * - Wishbone bus control and status registers
+ * - Wishbone bus control and status registers behind a
+ *   registered (B4 pipelined-mode) front end
  * - Logic analyzer integration for debugging
  * - Interrupt support for both SPI and UART
+ * - DMA engine moving data between the peripheral FIFOs and
+ *   an on-chip buffer without CPU involvement
+ * - SPI <-> UART hardware bridge selected from CONTROL_REG
+ * - SPI and UART cores clocked from user_clock2, reached
+ *   through Wishbone clock-domain-crossing bridges
+ * - Dual/quad SPI master sharing the SPI pads, with IO2/IO3
+ *   on io[15]/io[16]
+ * - N_UART UART channels with a shared interrupt status
+ *   register; channel 0 at 0x1000 on io[9]/io[10], channel
+ *   i > 0 at 0x3000 + i*0x1000 on io[15+2i]/io[16+2i]
+ * - Interrupt coalescer folding SPI, UART and DMA events
+ *   into irq[2]
+ * - Performance counters for bus traffic and FIFO usage,
+ *   sampled atomically by a snapshot-and-clear control
+ * - Triggered trace buffer for Wishbone, IRQ and pin events,
+ *   read through Wishbone or la_data_out[127:96]
+ * - SPI slave at 0xE000 for an external host, taking over the
+ *   SPI pads when CONTROL_REG[2] is set
+ * - Fractional baud generator and auto-baud detection for UART
+ *   channel 0
+ * - CRC-16/CRC-32 engine running over the SPI and UART TX and
+ *   RX byte streams
+ * - SLIP/COBS framing engine in front of UART channel 0
+ * - Aggregated SPI/UART status snapshot readable in a single
+ *   access, refreshed in the background from CONTROL_REG[3]
+ * - Idle clock gating of the SPI and UART cores with wake on
+ *   register access or pad activity, from CONTROL_REG[5:4]
+ * - 128-bit logic analyzer mailbox into the SPI and UART
+ *   FIFOs, taking over la_data_out while CONTROL_REG[8] is set
  *
  *-------------------------------------------------------------
  */
 
 module user_proj_example #(
-    parameter BITS = 16
+    parameter BITS = 16,
+    parameter N_UART = 2    // 1-11
 )(
 `ifdef USE_POWER_PINS
     inout vccd1,	// User area 1 1.8V supply
@@ -57,10 +88,13 @@ module user_proj_example #(
     output [127:0] la_data_out,
     input  [127:0] la_oenb,
 
-    // IOs - only the pins we use (5-14)
-    input  [14:5] io_in,
-    output [14:5] io_out,
-    output [14:5] io_oeb,
+    // IOs - user GPIOs 5-37 (17 and up are currently unused)
+    input  [37:5] io_in,
+    output [37:5] io_out,
+    output [37:5] io_oeb,
+
+    // Independent clock for the SPI/UART cores
+    input user_clock2,
 
     // IRQ
     output [2:0] irq
@@ -70,153 +104,1016 @@ module user_proj_example #(
     wire clk = wb_clk_i;
     wire rst = wb_rst_i;
 
-    // Wishbone interface signals
-    wire wb_valid = wbs_cyc_i && wbs_stb_i;
-    wire [3:0] wb_sel = wbs_sel_i;
-    wire [31:0] wb_addr = wbs_adr_i;
-    wire [31:0] wb_data_in = wbs_dat_i;
+    // Serial engine clock domain. Reset is synchronised into it so both
+    // domains leave reset cleanly whatever the clock ratio.
+    wire ser_clk = user_clock2;
+    reg [1:0] ser_rst_sync;
+
+    always @(posedge ser_clk) begin
+        ser_rst_sync <= {ser_rst_sync[0], rst};
+    end
+
+    wire ser_rst = ser_rst_sync[1];
+
+    // Core clock gating (ser_clk side)
+    wire spi_core_clk;
+    wire spi_clk_stopped;
+    wire [N_UART-1:0] uart_clk_stopped;
+    wire cg_spi_ser, cg_uart_ser;
+    wire [3:0] cg_idle_ser;
+
+    // Wishbone interface signals (registered request from the front end)
+    wire wb_valid;
+    wire [3:0] wb_sel;
+    wire [15:0] wb_addr;
+    wire [31:0] wb_data_in;
     wire [31:0] wb_data_out;
-    wire wb_we = wbs_we_i;
+    wire wb_we;
     wire wb_ack;
 
-    // Address decoding
-    wire spi_sel = (wb_addr[15:12] == 4'h0);  // 0x0000-0x0FFF
-    wire uart_sel = (wb_addr[15:12] == 4'h1); // 0x1000-0x1FFF
-    wire ctrl_sel = (wb_addr[15:12] == 4'hF); // 0xF000-0xFFFF
+    // Address decoding, done on the incoming address and registered
+    // one-hot by the front end
+    localparam DEC_BUS = 0;
+    localparam DEC_CTRL = 1;
+    localparam DEC_DMA = 2;
+    localparam DEC_IRQC = 3;
+    localparam DEC_TRACE = 4;
+    localparam DEC_BAUD = 5;
+    localparam DEC_CRC = 6;
+    localparam DEC_FRM = 7;
+    localparam NDEC = 8;
+
+    wire [15:0] host_addr = wbs_adr_i[15:0];
+    wire spi_sel = (host_addr[15:12] == 4'h0);  // 0x0000-0x0FFF
+    wire uart_sel = (host_addr[15:12] == 4'h1); // 0x1000-0x1FFF
+    wire buf_sel = (host_addr[15:12] == 4'h2);  // 0x2000-0x2FFF
+    wire qspi_sel = (host_addr[15:12] == 4'h3); // 0x3000-0x3FFF
+    wire uartx_sel = (host_addr[15:12] >= 4'h4) &&
+                     (host_addr[15:12] < 4'h3 + N_UART); // UART channels 1..N_UART-1
+    wire sslv_sel = (host_addr[15:12] == 4'hE); // 0xE000-0xEFFF
+    wire ctrl_sel = (host_addr[15:12] == 4'hF); // 0xF000-0xFFFF
+
+    wire [NDEC-1:0] host_dec;
+    assign host_dec[DEC_BUS] = spi_sel || uart_sel || buf_sel || qspi_sel || uartx_sel || sslv_sel;
+    assign host_dec[DEC_CTRL] = ctrl_sel && (host_addr[11:7] == 5'h00); // 0xF000-0xF07F
+    assign host_dec[DEC_DMA] = ctrl_sel && (host_addr[11:5] == 7'h04);  // 0xF080-0xF09F
+    assign host_dec[DEC_IRQC] = ctrl_sel && (host_addr[11:5] == 7'h05); // 0xF0A0-0xF0BF
+    assign host_dec[DEC_TRACE] = ctrl_sel && (host_addr[11:6] == 6'h03); // 0xF0C0-0xF0FF
+    assign host_dec[DEC_BAUD] = ctrl_sel && (host_addr[11:5] == 7'h08); // 0xF100-0xF11F
+    assign host_dec[DEC_CRC] = ctrl_sel && (host_addr[11:5] == 7'h09);  // 0xF120-0xF13F
+    assign host_dec[DEC_FRM] = ctrl_sel && (host_addr[11:5] == 7'h0A);  // 0xF140-0xF15F
+
+    wire [NDEC-1:0] wb_dec;
+    wire ctrl_regs_sel = wb_dec[DEC_CTRL];
+    wire dma_sel = wb_dec[DEC_DMA];
+    wire irqc_sel = wb_dec[DEC_IRQC];
+    wire trace_sel = wb_dec[DEC_TRACE];
+    wire baud_sel = wb_dec[DEC_BAUD];
+    wire crc_sel = wb_dec[DEC_CRC];
+    wire frm_sel = wb_dec[DEC_FRM];
+
+    // Local bus shared by the host, the DMA master, the SPI/UART
+    // bridge, the UART framer, the LA mailbox and the status poller.
+    // SPI, UART, QSPI, the SPI slave and the DMA buffer sit behind
+    // it; the control region is host-only so status can be polled
+    // while they run.
+    wire host_bus_req = wb_valid && wb_dec[DEC_BUS];
+
+    wire bus_valid;
+    wire bus_we;
+    wire [3:0] bus_sel;
+    wire [15:0] bus_addr;
+    wire [31:0] bus_data_in;
+    wire [31:0] bus_data_out;
+    wire bus_ack;
+
+    wire bus_spi_sel = (bus_addr[15:12] == 4'h0);
+    wire [N_UART-1:0] bus_uart_chan;
+    wire bus_uart_sel = |bus_uart_chan;
+    wire bus_buf_sel = (bus_addr[15:12] == 4'h2);
+    wire bus_qspi_sel = (bus_addr[15:12] == 4'h3);
+    wire bus_sslv_sel = (bus_addr[15:12] == 4'hE);
 
-    // SPI interface
+    // UART channel 0 keeps the 0x1000 window; the others follow QSPI
+    genvar gi;
+    generate
+        for (gi = 0; gi < N_UART; gi = gi + 1) begin : g_uart_dec
+            assign bus_uart_chan[gi] = (bus_addr[15:12] == ((gi == 0) ? 4'h1 : 4'h3 + gi));
+        end
+    endgenerate
+
+    // Window offsets 0xE00-0xFFF reach the IP FIFO and interrupt
+    // registers at 0xFE00-0xFFFF
+    wire [15:0] ip_addr = {(bus_addr[11:9] == 3'b111) ? 4'hF : 4'h0, bus_addr[11:0]};
+
+    // SPI interface (local bus side of the CDC bridge)
     wire spi_ack;
     wire [31:0] spi_data_out;
     wire spi_irq;
 
-    // UART interface
+    // SPI interface (ser_clk side)
+    wire spi_ip_valid;
+    wire spi_ip_we;
+    wire [3:0] spi_ip_sel;
+    wire [15:0] spi_ip_addr;
+    wire [31:0] spi_ip_data_in;
+    wire [31:0] spi_ip_data_out;
+    wire spi_ip_ack;
+    wire spi_ip_irq;
+
+    // UART array interface
     wire uart_ack;
     wire [31:0] uart_data_out;
-    wire uart_irq;
+    wire [N_UART-1:0] uart_irq_vec;
+    wire frm_irq;
+    wire uart_irq = (|uart_irq_vec) || frm_irq;
+
+    // QSPI interface (local bus side of the CDC bridge)
+    wire qspi_ack;
+    wire [31:0] qspi_data_out;
+
+    // QSPI interface (ser_clk side)
+    wire qspi_ip_valid;
+    wire qspi_ip_we;
+    wire [3:0] qspi_ip_sel;
+    wire [15:0] qspi_ip_addr;
+    wire [31:0] qspi_ip_data_in;
+    wire [31:0] qspi_ip_data_out;
+    wire qspi_ip_ack;
+    wire qspi_en;
+    wire qspi_sclk;
+    wire qspi_csb;
+    wire [3:0] qspi_io_out;
+    wire [3:0] qspi_io_oe;
+
+    // SPI slave interface
+    wire sslv_ack;
+    wire [31:0] sslv_data_out;
+    wire sslv_miso;
+    wire sslv_miso_oe;
+    wire sslv_active;
+    wire sslv_irq;
+    wire sslv_overrun_evt;
+    wire sslv_underrun_evt;
+
+    // DMA buffer interface
+    wire buf_ack;
+    wire [31:0] buf_data_out;
 
     // Control registers
     wire ctrl_ack;
     wire [31:0] ctrl_data_out;
 
+    // DMA engine
+    wire dma_ack;
+    wire [31:0] dma_data_out;
+    wire dma_m_valid;
+    wire dma_m_we;
+    wire [3:0] dma_m_sel;
+    wire [15:0] dma_m_addr;
+    wire [31:0] dma_m_data_out;
+    wire dma_irq;
+    wire dma_done_evt;
+
+    // Interrupt coalescer
+    wire irqc_ack;
+    wire [31:0] irqc_data_out;
+    wire irqc_irq;
+
+    // Trace buffer
+    wire trace_ack;
+    wire [31:0] trace_data_out;
+    wire [31:0] trace_la_data;
+    wire [7:0] trace_pins;
+
+    // UART channel 0 baud generator (local bus side of the CDC bridge)
+    wire baud_ack;
+    wire [31:0] baud_data_out;
+
+    // UART channel 0 baud generator (ser_clk side)
+    wire baud_ip_valid;
+    wire baud_ip_we;
+    wire [15:0] baud_ip_addr;
+    wire [31:0] baud_ip_data_in;
+    wire [31:0] baud_ip_data_out;
+    wire baud_ip_ack;
+    wire uart0_core_en;
+
+    // CRC engine
+    wire crc_ack;
+    wire [31:0] crc_data_out;
+
+    // UART framer
+    wire frm_ack;
+    wire [31:0] frm_data_out;
+    wire frm_m_valid;
+    wire frm_m_we;
+    wire [3:0] frm_m_sel;
+    wire [15:0] frm_m_addr;
+    wire [31:0] frm_m_data_out;
+
+    // LA mailbox
+    wire lam_m_valid;
+    wire lam_m_we;
+    wire [3:0] lam_m_sel;
+    wire [15:0] lam_m_addr;
+    wire [31:0] lam_m_data_out;
+    wire [127:0] lam_la_out;
+
+    // Status poller
+    wire poll_m_valid;
+    wire poll_m_we;
+    wire [3:0] poll_m_sel;
+    wire [15:0] poll_m_addr;
+    wire [31:0] poll_m_data_out;
+    wire [25:0] poll_status;
+    wire poll_valid;
+
+    // SPI/UART bridge
+    wire [31:0] control;
+    wire bridge_m_valid;
+    wire bridge_m_we;
+    wire [3:0] bridge_m_sel;
+    wire [15:0] bridge_m_addr;
+    wire [31:0] bridge_m_data_out;
+
     // GPIO assignments
     // SPI: io[5]=MOSI, io[6]=MISO, io[7]=SCLK, io[8]=CSB
-    // UART: io[9]=TX, io[10]=RX
+    // UART: io[9]=TX, io[10]=RX (channel 0)
+    // UART channel i > 0: io[15+2i]=TX, io[16+2i]=RX
     // Status LEDs: io[11]=SPI_ACTIVE, io[12]=UART_ACTIVE
     // Control: io[13]=SPI_ENABLE, io[14]=UART_ENABLE
+    // QSPI: io[5]=IO0, io[6]=IO1, io[7]=SCLK, io[8]=CSB, io[15]=IO2, io[16]=IO3
+    // SPI slave: io[5]=MOSI, io[6]=MISO, io[7]=SCLK, io[8]=CSB (host drives
+    // all but MISO)
 
     // SPI signals
     wire spi_mosi, spi_miso, spi_sclk, spi_csb;
     wire spi_enable = io_in[13];
 
+    // QSPI owns the SPI pads while it is enabled and SPI_ENABLE is high
+    wire qspi_pad_en = qspi_en && spi_enable;
+
+    // The SPI slave owns them instead while CONTROL_REG[2] is set
+    wire spi_slave_mode = control[2] && spi_enable;
+
     // UART signals
-    wire uart_tx, uart_rx;
+    wire [N_UART-1:0] uart_tx;
+    wire [N_UART-1:0] uart_rx;
     wire uart_enable = io_in[14];
 
+    assign uart_rx[0] = io_in[10];
+    generate
+        for (gi = 1; gi < N_UART; gi = gi + 1) begin : g_uart_rx
+            assign uart_rx[gi] = io_in[16 + 2*gi];
+        end
+    endgenerate
+
     // Status signals - connect to actual signals from IPs
-    wire spi_active = spi_enable && (spi_csb == 1'b0); // Active when CSB is low
-    wire uart_active = uart_enable && (uart_tx != 1'b1); // Active when TX is not idle
+    wire spi_active_ser = spi_enable && (qspi_pad_en ? !qspi_csb : !spi_csb); // Active when CSB is low
+    wire uart_active_ser = uart_enable && !(&uart_tx); // Active when any TX is not idle
+
+    // IRQ, activity and clock gating flags synchronised into the
+    // Wishbone clock domain
+    wire spi_master_active, uart_active;
+    wire spi_clk_off, uart_clk_off;
+
+    cdc_sync #(
+        .WIDTH(5)
+    ) ser_status_sync (
+        .clk(clk),
+        .rst(rst),
+        .d({&uart_clk_stopped, spi_clk_stopped, uart_active_ser, spi_active_ser, spi_ip_irq}),
+        .q({uart_clk_off, spi_clk_off, uart_active, spi_master_active, spi_irq})
+    );
+
+    wire spi_active = spi_slave_mode ? sslv_active : spi_master_active;
+
+    // Local bus arbitration. Ownership only changes while the current
+    // owner has no access in flight, so a slave never acks the wrong
+    // master. Requesters are served round-robin; an idle bus parks on
+    // the host. The status poller only gets the bus from the host, when
+    // nobody else wants it.
+    localparam OWN_HOST = 3'd0;
+    localparam OWN_DMA = 3'd1;
+    localparam OWN_BRIDGE = 3'd2;
+    localparam OWN_FRAMER = 3'd3;
+    localparam OWN_POLL = 3'd4;
+    localparam OWN_LA = 3'd5;
+
+    reg [2:0] bus_owner;
+
+    wire owner_busy = (bus_owner == OWN_DMA) ? dma_m_valid :
+                      (bus_owner == OWN_BRIDGE) ? bridge_m_valid :
+                      (bus_owner == OWN_FRAMER) ? frm_m_valid :
+                      (bus_owner == OWN_LA) ? lam_m_valid :
+                      (bus_owner == OWN_POLL) ? poll_m_valid : host_bus_req;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            bus_owner <= OWN_HOST;
+        end else if (!owner_busy) begin
+            case (bus_owner)
+                OWN_DMA: bus_owner <= bridge_m_valid ? OWN_BRIDGE :
+                                      frm_m_valid ? OWN_FRAMER :
+                                      lam_m_valid ? OWN_LA : OWN_HOST;
+                OWN_BRIDGE: bus_owner <= frm_m_valid ? OWN_FRAMER :
+                                         lam_m_valid ? OWN_LA :
+                                         (dma_m_valid && !host_bus_req) ? OWN_DMA : OWN_HOST;
+                OWN_FRAMER: bus_owner <= lam_m_valid ? OWN_LA :
+                                         (dma_m_valid && !host_bus_req) ? OWN_DMA :
+                                         (bridge_m_valid && !host_bus_req) ? OWN_BRIDGE : OWN_HOST;
+                OWN_LA: bus_owner <= (dma_m_valid && !host_bus_req) ? OWN_DMA :
+                                     (bridge_m_valid && !host_bus_req) ? OWN_BRIDGE :
+                                     (frm_m_valid && !host_bus_req) ? OWN_FRAMER : OWN_HOST;
+                OWN_POLL: bus_owner <= dma_m_valid ? OWN_DMA :
+                                       bridge_m_valid ? OWN_BRIDGE :
+                                       frm_m_valid ? OWN_FRAMER :
+                                       lam_m_valid ? OWN_LA : OWN_HOST;
+                default: bus_owner <= dma_m_valid ? OWN_DMA :
+                                      bridge_m_valid ? OWN_BRIDGE :
+                                      frm_m_valid ? OWN_FRAMER :
+                                      lam_m_valid ? OWN_LA :
+                                      poll_m_valid ? OWN_POLL : OWN_HOST;
+            endcase
+        end
+    end
+
+    wire dma_owns = (bus_owner == OWN_DMA);
+    wire bridge_owns = (bus_owner == OWN_BRIDGE);
+    wire frm_owns = (bus_owner == OWN_FRAMER);
+    wire lam_owns = (bus_owner == OWN_LA);
+    wire poll_owns = (bus_owner == OWN_POLL);
+    wire host_owns = (bus_owner == OWN_HOST);
+
+    assign bus_valid = dma_owns ? dma_m_valid : bridge_owns ? bridge_m_valid :
+                       frm_owns ? frm_m_valid : lam_owns ? lam_m_valid :
+                       poll_owns ? poll_m_valid : host_bus_req;
+    assign bus_we = dma_owns ? dma_m_we : bridge_owns ? bridge_m_we :
+                    frm_owns ? frm_m_we : lam_owns ? lam_m_we :
+                    poll_owns ? poll_m_we : wb_we;
+    assign bus_sel = dma_owns ? dma_m_sel : bridge_owns ? bridge_m_sel :
+                     frm_owns ? frm_m_sel : lam_owns ? lam_m_sel :
+                     poll_owns ? poll_m_sel : wb_sel;
+    assign bus_addr = dma_owns ? dma_m_addr : bridge_owns ? bridge_m_addr :
+                      frm_owns ? frm_m_addr : lam_owns ? lam_m_addr :
+                      poll_owns ? poll_m_addr : wb_addr;
+    assign bus_data_in = dma_owns ? dma_m_data_out : bridge_owns ? bridge_m_data_out :
+                         frm_owns ? frm_m_data_out : lam_owns ? lam_m_data_out :
+                         poll_owns ? poll_m_data_out : wb_data_in;
+
+    assign bus_data_out = bus_spi_sel ? spi_data_out :
+                         bus_uart_sel ? uart_data_out :
+                         bus_buf_sel ? buf_data_out :
+                         bus_qspi_sel ? qspi_data_out :
+                         bus_sslv_sel ? sslv_data_out : 32'h0;
+
+    assign bus_ack = (bus_spi_sel && spi_ack) ||
+                    (bus_uart_sel && uart_ack) ||
+                    (bus_buf_sel && buf_ack) ||
+                    (bus_qspi_sel && qspi_ack) ||
+                    (bus_sslv_sel && sslv_ack);
+
+    wire dma_m_ack = dma_owns && bus_ack;
+    wire bridge_m_ack = bridge_owns && bus_ack;
+    wire frm_m_ack = frm_owns && bus_ack;
+    wire lam_m_ack = lam_owns && bus_ack;
+    wire poll_m_ack = poll_owns && bus_ack;
+
+    // Performance counter events, taken from completed local bus accesses
+    // so host, DMA and bridge traffic are all counted. Window offsets
+    // 0x000/0x004 are the RX/TX data registers and 0xE00/0xE10 the FIFO
+    // level registers. Status poller reads are left out so enabling it
+    // does not swamp the FIFO level events.
+    wire bus_done = bus_valid && bus_ack;
+    wire bus_rx_data = bus_done && !bus_we && (bus_addr[11:0] == 12'h000);
+    wire bus_tx_data = bus_done && bus_we && (bus_addr[11:0] == 12'h004);
+    wire bus_rx_level = bus_done && !bus_we && !poll_owns && (bus_addr[11:0] == 12'hE00);
+    wire bus_tx_level = bus_done && !bus_we && !poll_owns && (bus_addr[11:0] == 12'hE10);
+
+    // {UART TX, UART RX, SPI TX, SPI RX} level reads
+    wire [3:0] perf_lvl_rd = {bus_uart_sel && bus_tx_level, bus_uart_sel && bus_rx_level,
+                              bus_spi_sel && bus_tx_level, bus_spi_sel && bus_rx_level};
+
+    wire [9:0] perf_evt;
+    assign perf_evt[0] = wbs_ack_o;                                // Wishbone accesses
+    assign perf_evt[1] = wbs_cyc_i && wbs_stb_i && !wbs_ack_o;     // Wishbone wait states
+    assign perf_evt[2] = bus_spi_sel && bus_tx_data;               // SPI TX bytes
+    assign perf_evt[3] = bus_spi_sel && bus_rx_data;               // SPI RX bytes
+    assign perf_evt[4] = bus_uart_sel && bus_tx_data;              // UART TX bytes
+    assign perf_evt[5] = bus_uart_sel && bus_rx_data;              // UART RX bytes
+    assign perf_evt[6] = bus_qspi_sel && bus_tx_data;              // QSPI TX bytes
+    assign perf_evt[7] = bus_qspi_sel && bus_rx_data;              // QSPI RX bytes
+    assign perf_evt[8] = sslv_overrun_evt;                         // SPI slave bytes dropped
+    assign perf_evt[9] = sslv_underrun_evt;                        // SPI slave bytes sent empty
 
     // Wishbone data output multiplexing
-    assign wb_data_out = spi_sel ? spi_data_out :
-                        uart_sel ? uart_data_out :
-                        ctrl_sel ? ctrl_data_out : 32'h0;
+    assign wb_data_out = ctrl_regs_sel ? ctrl_data_out :
+                        dma_sel ? dma_data_out :
+                        irqc_sel ? irqc_data_out :
+                        trace_sel ? trace_data_out :
+                        baud_sel ? baud_data_out :
+                        crc_sel ? crc_data_out :
+                        frm_sel ? frm_data_out :
+                        (host_bus_req && host_owns) ? bus_data_out : 32'h0;
 
     // Wishbone acknowledge
-    assign wb_ack = (spi_sel && spi_ack) || 
-                   (uart_sel && uart_ack) || 
-                   (ctrl_sel && ctrl_ack);
+    assign wb_ack = (host_bus_req && host_owns && bus_ack) ||
+                   (ctrl_regs_sel && ctrl_ack) ||
+                   (dma_sel && dma_ack) ||
+                   (irqc_sel && irqc_ack) ||
+                   (trace_sel && trace_ack) ||
+                   (baud_sel && baud_ack) ||
+                   (crc_sel && crc_ack) ||
+                   (frm_sel && frm_ack);
+
+    // Wishbone front end. The Caravel management SoC is a classic
+    // master and the wrapper has no stall line, so the front end runs in
+    // classic-compatible mode and the stall output stays internal.
+    wire wb_stall;
+
+    wb_frontend #(
+        .NSLV(NDEC),
+        .CLASSIC(1)
+    ) wb_fe (
+        .clk(clk),
+        .rst(rst),
+        .cyc_i(wbs_cyc_i),
+        .stb_i(wbs_stb_i),
+        .we_i(wbs_we_i),
+        .sel_i(wbs_sel_i),
+        .adr_i(host_addr),
+        .dat_i(wbs_dat_i),
+        .dec_i(host_dec),
+        .stall_o(wb_stall),
+        .ack_o(wbs_ack_o),
+        .dat_o(wbs_dat_o),
+        .req_valid(wb_valid),
+        .req_we(wb_we),
+        .req_sel(wb_sel),
+        .req_addr(wb_addr),
+        .req_data(wb_data_in),
+        .req_dec(wb_dec),
+        .rsp_ack(wb_ack),
+        .rsp_data(wb_data_out)
+    );
 
-    // Output assignments
-    assign wbs_dat_o = wb_data_out;
-    assign wbs_ack_o = wb_ack;
+    // Pad and LA outputs are driven straight from flops so their paths
+    // to the Caravel boundary do not depend on the SPI/UART logic depth
+    // (the SPI slave's MISO comes from its own flop, see below)
+    wire [37:5] io_out_d;
+    wire [37:5] io_oeb_d;
+    wire [127:0] la_data_out_d;
+    reg [37:5] io_out_q;
+    reg [37:5] io_oeb_q;
+    reg [127:0] la_data_out_q;
 
     // GPIO output assignments - only assign the pins we use
-    assign io_out[5] = spi_enable ? spi_mosi : 1'b0;    // SPI MOSI
-    assign io_out[6] = 1'b0;                            // SPI MISO (input, but assign to avoid warning)
-    assign io_out[7] = spi_enable ? spi_sclk : 1'b0;    // SPI SCLK
-    assign io_out[8] = spi_enable ? spi_csb : 1'b1;     // SPI CSB (active low)
-    assign io_out[9] = uart_enable ? uart_tx : 1'b1;    // UART TX (idle high)
-    assign io_out[10] = 1'b0;                           // UART RX (input, but assign to avoid warning)
-    assign io_out[11] = spi_active;                     // SPI activity LED
-    assign io_out[12] = uart_active;                    // UART activity LED
-    assign io_out[13] = 1'b0;                           // SPI enable (input, but assign to avoid warning)
-    assign io_out[14] = 1'b0;                           // UART enable (input, but assign to avoid warning)
+    assign io_out_d[5] = spi_slave_mode ? 1'b0 :
+                         qspi_pad_en ? qspi_io_out[0] :
+                         spi_enable ? spi_mosi : 1'b0;  // SPI MOSI / QSPI IO0
+    assign io_out_d[6] = spi_slave_mode ? sslv_miso :
+                         qspi_pad_en ? qspi_io_out[1] : 1'b0; // SPI MISO / QSPI IO1
+    assign io_out_d[7] = spi_slave_mode ? 1'b0 :
+                         qspi_pad_en ? qspi_sclk :
+                         spi_enable ? spi_sclk : 1'b0;  // SPI SCLK
+    assign io_out_d[8] = spi_slave_mode ? 1'b0 :
+                         qspi_pad_en ? qspi_csb :
+                         spi_enable ? spi_csb : 1'b1;   // SPI CSB (active low)
+    assign io_out_d[9] = uart_enable ? uart_tx[0] : 1'b1; // UART TX (idle high)
+    assign io_out_d[10] = 1'b0;                           // UART RX (input, but assign to avoid warning)
+    assign io_out_d[11] = spi_active;                     // SPI activity LED
+    assign io_out_d[12] = uart_active;                    // UART activity LED
+    assign io_out_d[13] = 1'b0;                           // SPI enable (input, but assign to avoid warning)
+    assign io_out_d[14] = 1'b0;                           // UART enable (input, but assign to avoid warning)
+    assign io_out_d[15] = qspi_pad_en ? qspi_io_out[2] : 1'b0; // QSPI IO2
+    assign io_out_d[16] = qspi_pad_en ? qspi_io_out[3] : 1'b0; // QSPI IO3
+    assign io_out_d[37] = 1'b0;                           // Unused
 
     // GPIO direction control - only control the pins we use
-    assign io_oeb[5] = ~spi_enable;     // MOSI output when enabled
-    assign io_oeb[6] = 1'b0;            // MISO always input
-    assign io_oeb[7] = ~spi_enable;     // SCLK output when enabled
-    assign io_oeb[8] = ~spi_enable;     // CSB output when enabled
-    assign io_oeb[9] = ~uart_enable;    // TX output when enabled
-    assign io_oeb[10] = 1'b0;           // RX always input
-    assign io_oeb[11] = 1'b0;           // Status LED output
-    assign io_oeb[12] = 1'b0;           // Status LED output
-    assign io_oeb[13] = 1'b1;           // SPI enable input
-    assign io_oeb[14] = 1'b1;           // UART enable input
+    assign io_oeb_d[5] = spi_slave_mode ? 1'b1 :
+                         qspi_pad_en ? ~qspi_io_oe[0] : ~spi_enable; // MOSI output when enabled
+    assign io_oeb_d[6] = spi_slave_mode ? ~sslv_miso_oe :
+                         qspi_pad_en ? ~qspi_io_oe[1] : 1'b1;        // MISO input unless QSPI drives IO1
+    assign io_oeb_d[7] = spi_slave_mode | ~spi_enable; // SCLK output when enabled
+    assign io_oeb_d[8] = spi_slave_mode | ~spi_enable; // CSB output when enabled
+    assign io_oeb_d[9] = ~uart_enable;    // TX output when enabled
+    assign io_oeb_d[10] = 1'b1;           // RX always input
+    assign io_oeb_d[11] = 1'b0;           // Status LED output
+    assign io_oeb_d[12] = 1'b0;           // Status LED output
+    assign io_oeb_d[13] = 1'b1;           // SPI enable input
+    assign io_oeb_d[14] = 1'b1;           // UART enable input
+    assign io_oeb_d[15] = qspi_pad_en ? ~qspi_io_oe[2] : 1'b1; // QSPI IO2
+    assign io_oeb_d[16] = qspi_pad_en ? ~qspi_io_oe[3] : 1'b1; // QSPI IO3
+    assign io_oeb_d[37] = 1'b1;           // Unused, left as input
+
+    // UART channels 1-10 on io[17:36]; pads of absent channels are inputs
+    generate
+        for (gi = 1; gi < 11; gi = gi + 1) begin : g_uart_pads
+            if (gi < N_UART) begin : g_used
+                assign io_out_d[15 + 2*gi] = uart_enable ? uart_tx[gi] : 1'b1; // TX (idle high)
+                assign io_oeb_d[15 + 2*gi] = ~uart_enable;                      // TX output when enabled
+            end else begin : g_unused
+                assign io_out_d[15 + 2*gi] = 1'b0;
+                assign io_oeb_d[15 + 2*gi] = 1'b1;
+            end
+            assign io_out_d[16 + 2*gi] = 1'b0; // RX (input)
+            assign io_oeb_d[16 + 2*gi] = 1'b1; // RX always input
+        end
+    endgenerate
 
     // Interrupt assignments
-    assign irq[0] = spi_irq;
+    assign irq[0] = spi_irq || sslv_irq;
     assign irq[1] = uart_irq;
-    assign irq[2] = 1'b0;
+    assign irq[2] = irqc_irq;
+
+    // Logic analyzer outputs: debug mirror, or the mailbox response
+    // while CONTROL_REG[8] is set
+    wire [127:0] la_debug;
+
+    assign la_debug[31:0] = wb_data_out;
+    assign la_debug[47:32] = wb_addr[15:0];
+    assign la_debug[63:48] = {spi_active, uart_active, spi_enable, uart_enable, 
+                                   spi_mosi, io_in[6], spi_sclk, spi_csb, 
+                                   uart_tx[0], io_in[10], 6'b0};
+    assign la_debug[95:64] = {spi_irq, uart_irq, 30'b0};
+    assign la_debug[127:96] = trace_la_data;
+
+    assign la_data_out_d = control[8] ? lam_la_out : la_debug;
+
+    // Pads driven by the serial engines are registered in ser_clk, the
+    // rest in clk. SER_PADS = io[5:9], io[15:16] and the extra UART TX
+    // pads; TX and CSB reset high. The SPI slave runs in clk, so io[5:8]
+    // move to the clk registers in slave mode.
+    localparam [37:5] UART_TX_PADS = 33'h0_5555_5000 & ((33'h1 << (10 + 2*N_UART)) - 33'h1);
+    localparam [37:5] SER_PADS = 33'h0_0000_0C1F | UART_TX_PADS;
+    localparam [37:5] SSLV_PADS = 33'h0_0000_000F;
+    localparam [37:5] IO_OUT_RESET = 33'h0_0000_0018 | UART_TX_PADS;
+
+    wire [37:5] ser_pads = spi_slave_mode ? (SER_PADS & ~SSLV_PADS) : SER_PADS;
+
+    reg [37:5] ser_io_out_q;
+    reg [37:5] ser_io_oeb_q;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            io_out_q <= IO_OUT_RESET;
+            io_oeb_q <= {33{1'b1}};
+            la_data_out_q <= 128'h0;
+        end else begin
+            io_out_q <= io_out_d;
+            io_oeb_q <= io_oeb_d;
+            la_data_out_q <= la_data_out_d;
+        end
+    end
+
+    always @(posedge ser_clk) begin
+        if (ser_rst) begin
+            ser_io_out_q <= IO_OUT_RESET;
+            ser_io_oeb_q <= {33{1'b1}};
+        end else begin
+            ser_io_out_q <= io_out_d;
+            ser_io_oeb_q <= io_oeb_d;
+        end
+    end
+
+    wire [37:5] io_out_r = (ser_io_out_q & ser_pads) | (io_out_q & ~ser_pads);
+    wire [37:5] io_oeb_r = (ser_io_oeb_q & ser_pads) | (io_oeb_q & ~ser_pads);
+
+    // In slave mode MISO skips the pad register: sslv_miso is the shift
+    // register flop itself, so it moves 3 clk after the SCLK edge at the
+    // pad instead of 4, which keeps clk/8 SCLK within timing
+    assign io_out = spi_slave_mode ? {io_out_r[37:7], sslv_miso, io_out_r[5]} : io_out_r;
+    assign io_oeb = spi_slave_mode ? {io_oeb_r[37:7], ~sslv_miso_oe, io_oeb_r[5]} : io_oeb_r;
+    assign la_data_out = la_data_out_q;
+
+    // Local bus -> ser_clk crossings for the SPI and QSPI register windows
+    wb_cdc_bridge spi_cdc (
+        .clk_a(clk),
+        .rst_a(rst),
+        .s_valid(bus_valid && bus_spi_sel),
+        .s_we(bus_we),
+        .s_sel(bus_sel),
+        .s_addr(ip_addr),
+        .s_data_in(bus_data_in),
+        .s_data_out(spi_data_out),
+        .s_ack(spi_ack),
+        .clk_b(ser_clk),
+        .rst_b(ser_rst),
+        .m_valid(spi_ip_valid),
+        .m_we(spi_ip_we),
+        .m_sel(spi_ip_sel),
+        .m_addr(spi_ip_addr),
+        .m_data_out(spi_ip_data_in),
+        .m_data_in(spi_ip_data_out),
+        .m_ack(spi_ip_ack)
+    );
 
-    // Logic analyzer outputs
-    assign la_data_out[31:0] = wb_data_out;
-    assign la_data_out[47:32] = wb_addr[15:0];
-    assign la_data_out[63:48] = {spi_active, uart_active, spi_enable, uart_enable, 
-                                 spi_mosi, io_in[6], spi_sclk, spi_csb, 
-                                 uart_tx, io_in[10], 6'b0};
-    assign la_data_out[95:64] = {spi_irq, uart_irq, 30'b0};
-    assign la_data_out[127:96] = 32'b0;
+    wb_cdc_bridge qspi_cdc (
+        .clk_a(clk),
+        .rst_a(rst),
+        .s_valid(bus_valid && bus_qspi_sel),
+        .s_we(bus_we),
+        .s_sel(bus_sel),
+        .s_addr(ip_addr),
+        .s_data_in(bus_data_in),
+        .s_data_out(qspi_data_out),
+        .s_ack(qspi_ack),
+        .clk_b(ser_clk),
+        .rst_b(ser_rst),
+        .m_valid(qspi_ip_valid),
+        .m_we(qspi_ip_we),
+        .m_sel(qspi_ip_sel),
+        .m_addr(qspi_ip_addr),
+        .m_data_out(qspi_ip_data_in),
+        .m_data_in(qspi_ip_data_out),
+        .m_ack(qspi_ip_ack)
+    );
+
+    // Clock gating controls, CONTROL_REG[15:12] and [5:4], are static
+    // while gating is in use so they only need a plain synchroniser
+    cdc_sync #(
+        .WIDTH(6)
+    ) cg_ctrl_sync (
+        .clk(ser_clk),
+        .rst(ser_rst),
+        .d({control[15:12], control[5:4]}),
+        .q({cg_idle_ser, cg_uart_ser, cg_spi_ser})
+    );
+
+    // SPI core clock, stopped while idle if CONTROL_REG[4] is set. A
+    // register access in flight, CSB low or an SCLK edge keeps it
+    // running.
+    reg spi_sclk_q;
+
+    always @(posedge ser_clk) begin
+        if (ser_rst)
+            spi_sclk_q <= 1'b0;
+        else
+            spi_sclk_q <= spi_sclk;
+    end
+
+    idle_clk_gate spi_cg (
+`ifdef USE_POWER_PINS
+        .vccd1(vccd1),
+        .vssd1(vssd1),
+`endif
+        .clk(ser_clk),
+        .rst(ser_rst),
+        .src_en(1'b1),
+        .enable(cg_spi_ser),
+        .idle_sel(cg_idle_ser),
+        .wake(spi_ip_valid || !spi_csb || (spi_sclk != spi_sclk_q)),
+        .hold_len(24'h0),
+        .gclk(spi_core_clk),
+        .stopped(spi_clk_stopped)
+    );
 
     // SPI IP instantiation
     CF_SPI_WB #(
         .CDW(8),
         .FAW(4)
     ) spi_inst (
-        .clk_i(clk),
-        .rst_i(rst),
-        .adr_i(wb_addr),
-        .dat_i(wb_data_in),
-        .dat_o(spi_data_out),
-        .sel_i(wb_sel),
-        .cyc_i(wb_valid && spi_sel),
-        .stb_i(wb_valid && spi_sel),
-        .ack_o(spi_ack),
-        .we_i(wb_we),
-        .IRQ(spi_irq),
+        .clk_i(spi_core_clk),
+        .rst_i(ser_rst),
+        .adr_i({16'h0, spi_ip_addr}),
+        .dat_i(spi_ip_data_in),
+        .dat_o(spi_ip_data_out),
+        .sel_i(spi_ip_sel),
+        .cyc_i(spi_ip_valid),
+        .stb_i(spi_ip_valid),
+        .ack_o(spi_ip_ack),
+        .we_i(spi_ip_we),
+        .IRQ(spi_ip_irq),
         .miso(io_in[6]),        // MISO from GPIO
         .mosi(spi_mosi),
         .csb(spi_csb),
         .sclk(spi_sclk)
     );
 
-    // UART IP instantiation
-    CF_UART_WB #(
-        .SC(8),
-        .MDW(9),
-        .GFLEN(8),
-        .FAW(4)
+    // UART channels, each behind its own ser_clk crossing
+    uart_array #(
+        .N(N_UART)
     ) uart_inst (
-        .clk_i(clk),
-        .rst_i(rst),
-        .adr_i(wb_addr),
-        .dat_i(wb_data_in),
-        .dat_o(uart_data_out),
-        .sel_i(wb_sel),
-        .cyc_i(wb_valid && uart_sel),
-        .stb_i(wb_valid && uart_sel),
-        .ack_o(uart_ack),
-        .we_i(wb_we),
-        .IRQ(uart_irq),
-        .rx(io_in[10]),          // RX from GPIO
-        .tx(uart_tx)
+`ifdef USE_POWER_PINS
+        .vccd1(vccd1),
+        .vssd1(vssd1),
+`endif
+        .clk(clk),
+        .rst(rst),
+        .s_valid(bus_valid),
+        .s_chan(bus_uart_chan),
+        .s_we(bus_we),
+        .s_sel(bus_sel),
+        .s_addr(ip_addr),
+        .s_data_in(bus_data_in),
+        .s_data_out(uart_data_out),
+        .s_ack(uart_ack),
+        .ser_clk(ser_clk),
+        .ser_rst(ser_rst),
+        .ch0_en(uart0_core_en),
+        .cg_enable(cg_uart_ser),
+        .cg_idle(cg_idle_ser),
+        .rx(uart_rx),
+        .tx(uart_tx),
+        .clk_stopped(uart_clk_stopped),
+        .irq(uart_irq_vec)
+    );
+
+    // Host -> ser_clk crossing for the baud generator registers
+    wb_cdc_bridge baud_cdc (
+        .clk_a(clk),
+        .rst_a(rst),
+        .s_valid(wb_valid && baud_sel),
+        .s_we(wb_we),
+        .s_sel(wb_sel),
+        .s_addr(wb_addr),
+        .s_data_in(wb_data_in),
+        .s_data_out(baud_data_out),
+        .s_ack(baud_ack),
+        .clk_b(ser_clk),
+        .rst_b(ser_rst),
+        .m_valid(baud_ip_valid),
+        .m_we(baud_ip_we),
+        .m_sel(),
+        .m_addr(baud_ip_addr),
+        .m_data_out(baud_ip_data_in),
+        .m_data_in(baud_ip_data_out),
+        .m_ack(baud_ip_ack)
+    );
+
+    // Fractional baud generator and auto-baud for UART channel 0
+    uart_baud baud_inst (
+        .clk(ser_clk),
+        .rst(ser_rst),
+        .wb_valid(baud_ip_valid),
+        .wb_we(baud_ip_we),
+        .wb_addr(baud_ip_addr[4:0]),
+        .wb_data_in(baud_ip_data_in),
+        .wb_data_out(baud_ip_data_out),
+        .wb_ack(baud_ip_ack),
+        .rx(io_in[10]),
+        .core_en(uart0_core_en)
+    );
+
+    // Dual/quad SPI master
+    qspi_master #(
+        .FAW(4)
+    ) qspi_inst (
+        .clk(ser_clk),
+        .rst(ser_rst),
+        .wb_valid(qspi_ip_valid),
+        .wb_we(qspi_ip_we),
+        .wb_addr(qspi_ip_addr),
+        .wb_data_in(qspi_ip_data_in),
+        .wb_data_out(qspi_ip_data_out),
+        .wb_ack(qspi_ip_ack),
+        .pad_en(qspi_en),
+        .sclk(qspi_sclk),
+        .csb(qspi_csb),
+        .io_out(qspi_io_out),
+        .io_oe(qspi_io_oe),
+        .io_in({io_in[16], io_in[15], io_in[6], io_in[5]})
+    );
+
+    // SPI slave, in the bus clock domain
+    spi_slave #(
+        .FAW(4)
+    ) sslv_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(bus_valid && bus_sslv_sel),
+        .wb_we(bus_we),
+        .wb_addr(ip_addr),
+        .wb_data_in(bus_data_in),
+        .wb_data_out(sslv_data_out),
+        .wb_ack(sslv_ack),
+        .enable(spi_slave_mode),
+        .sclk(io_in[7]),
+        .csb(io_in[8]),
+        .mosi(io_in[5]),
+        .miso(sslv_miso),
+        .miso_oe(sslv_miso_oe),
+        .selected(sslv_active),
+        .irq(sslv_irq),
+        .overrun_evt(sslv_overrun_evt),
+        .underrun_evt(sslv_underrun_evt)
+    );
+
+    // DMA staging buffer
+    dma_buffer #(
+        .AW(6)
+    ) dma_buf (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(bus_valid && bus_buf_sel),
+        .wb_we(bus_we),
+        .wb_sel(bus_sel),
+        .wb_addr(bus_addr[7:0]),
+        .wb_data_in(bus_data_in),
+        .wb_data_out(buf_data_out),
+        .wb_ack(buf_ack)
+    );
+
+    // DMA engine
+    dma_engine #(
+        .FIFO_DEPTH(16)
+    ) dma_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(wb_valid && dma_sel),
+        .wb_we(wb_we),
+        .wb_addr(wb_addr[4:0]),
+        .wb_data_in(wb_data_in),
+        .wb_data_out(dma_data_out),
+        .wb_ack(dma_ack),
+        .m_valid(dma_m_valid),
+        .m_we(dma_m_we),
+        .m_sel(dma_m_sel),
+        .m_addr(dma_m_addr),
+        .m_data_out(dma_m_data_out),
+        .m_data_in(bus_data_out),
+        .m_ack(dma_m_ack),
+        .irq(dma_irq),
+        .done_evt(dma_done_evt)
+    );
+
+    // Interrupt coalescer events: [0] a byte through an SPI master or
+    // slave data register, [1] a byte through any UART channel's data
+    // registers (RXDATA pops and TXDATA pushes, by any bus master),
+    // [2] a DMA transfer completing with IRQ_EN set
+    wire [2:0] irqc_evt = {dma_done_evt,
+                           bus_uart_sel && (bus_rx_data || bus_tx_data),
+                           (bus_spi_sel || bus_sslv_sel) && (bus_rx_data || bus_tx_data)};
+
+    irq_coalescer #(
+        .N(3)
+    ) irqc_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(wb_valid && irqc_sel),
+        .wb_we(wb_we),
+        .wb_addr(wb_addr[4:0]),
+        .wb_data_in(wb_data_in),
+        .wb_data_out(irqc_data_out),
+        .wb_ack(irqc_ack),
+        .evt(irqc_evt),
+        .irq(irqc_irq)
+    );
+
+    // CRC engine, fed the data register accesses of one stream each:
+    // {UART channel 0 RX, UART channel 0 TX, SPI RX, SPI TX}
+    crc_engine crc_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(wb_valid && crc_sel),
+        .wb_we(wb_we),
+        .wb_addr(wb_addr[4:0]),
+        .wb_data_in(wb_data_in),
+        .wb_data_out(crc_data_out),
+        .wb_ack(crc_ack),
+        .snoop_valid({bus_uart_chan[0] && bus_rx_data, bus_uart_chan[0] && bus_tx_data,
+                      bus_spi_sel && bus_rx_data, bus_spi_sel && bus_tx_data}),
+        .snoop_data(bus_we ? bus_data_in[7:0] : bus_data_out[7:0])
+    );
+
+    // Serial pins seen by the trace buffer:
+    // {IO3, IO2, UART RX, UART TX, CSB, SCLK, MISO, MOSI}
+    wire [3:0] trace_spi_pins = spi_slave_mode ? {io_in[8], io_in[7], io_out[6], io_in[5]} :
+                                                 {io_out[8], io_out[7], io_in[6], io_out[5]};
+
+    cdc_sync #(
+        .WIDTH(8)
+    ) trace_pin_sync (
+        .clk(clk),
+        .rst(rst),
+        .d({io_in[16], io_in[15], io_in[10], io_out[9], trace_spi_pins}),
+        .q(trace_pins)
+    );
+
+    // Trace buffer. Its own register accesses are not traced.
+    trace_buffer #(
+        .AW(5)
+    ) trace_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(wb_valid && trace_sel),
+        .wb_we(wb_we),
+        .wb_addr(wb_addr[5:0]),
+        .wb_data_in(wb_data_in),
+        .wb_data_out(trace_data_out),
+        .wb_ack(trace_ack),
+        .mon_wb(wb_valid && wb_ack && !trace_sel),
+        .mon_we(wb_we),
+        .mon_addr(wb_addr),
+        .mon_data(wb_we ? wb_data_in : wb_data_out),
+        .mon_irq(irq),
+        .mon_pins(trace_pins),
+        .la_data(trace_la_data)
+    );
+
+    // SPI <-> UART bridge, enabled by CONTROL_REG[1:0]
+    stream_bridge #(
+        .FIFO_DEPTH(16),
+        .SPI_WIN(4'h0),
+        .UART_WIN(4'h1)
+    ) bridge_inst (
+        .clk(clk),
+        .rst(rst),
+        .enable(control[1:0]),
+        .m_valid(bridge_m_valid),
+        .m_we(bridge_m_we),
+        .m_sel(bridge_m_sel),
+        .m_addr(bridge_m_addr),
+        .m_data_out(bridge_m_data_out),
+        .m_data_in(bus_data_out),
+        .m_ack(bridge_m_ack)
+    );
+
+    // SLIP/COBS framing in front of UART channel 0
+    uart_framer #(
+        .TX_AW(8),
+        .RX_AW(5),
+        .FIFO_DEPTH(16),
+        .UART_WIN(4'h1)
+    ) frm_inst (
+        .clk(clk),
+        .rst(rst),
+        .wb_valid(wb_valid && frm_sel),
+        .wb_we(wb_we),
+        .wb_addr(wb_addr[4:0]),
+        .wb_data_in(wb_data_in),
+        .wb_data_out(frm_data_out),
+        .wb_ack(frm_ack),
+        .m_valid(frm_m_valid),
+        .m_we(frm_m_we),
+        .m_sel(frm_m_sel),
+        .m_addr(frm_m_addr),
+        .m_data_out(frm_m_data_out),
+        .m_data_in(bus_data_out),
+        .m_ack(frm_m_ack),
+        .irq(frm_irq)
+    );
+
+    // LA mailbox, enabled by CONTROL_REG[8]. Requests come in on
+    // la_oenb[7:0], push data on la_data_in. The management side
+    // inverts la_oenb, so it is flipped back to the reg_la0_oenb value.
+    la_mailbox #(
+        .FIFO_DEPTH(16),
+        .SPI_WIN(4'h0),
+        .UART_WIN(4'h1)
+    ) lam_inst (
+        .clk(clk),
+        .rst(rst),
+        .enable(control[8]),
+        .la_in(la_data_in),
+        .la_ctrl(~la_oenb[7:0]),
+        .la_out(lam_la_out),
+        .m_valid(lam_m_valid),
+        .m_we(lam_m_we),
+        .m_sel(lam_m_sel),
+        .m_addr(lam_m_addr),
+        .m_data_out(lam_m_data_out),
+        .m_data_in(bus_data_out),
+        .m_ack(lam_m_ack)
+    );
+
+    // SPI/UART status poller, enabled by CONTROL_REG[3]; each SNAPSHOT
+    // read starts one round
+    wire snapshot_rd;
+
+    status_poller #(
+        .FIFO_DEPTH(16),
+        .SPI_WIN(4'h0),
+        .UART_WIN(4'h1),
+        .SSLV_WIN(4'hE)
+    ) poll_inst (
+        .clk(clk),
+        .rst(rst),
+        .enable(control[3]),
+        .start(snapshot_rd),
+        .spi_slave(spi_slave_mode),
+        .m_valid(poll_m_valid),
+        .m_we(poll_m_we),
+        .m_sel(poll_m_sel),
+        .m_addr(poll_m_addr),
+        .m_data_out(poll_m_data_out),
+        .m_data_in(bus_data_out),
+        .m_ack(poll_m_ack),
+        .status(poll_status),
+        .valid(poll_valid)
     );
 
+    // Status snapshot: polled FIFO and error state plus the live
+    // interrupt causes
+    wire [31:0] status_snap = {poll_valid, dma_irq, frm_irq, |(uart_irq_vec >> 1),
+                               uart_irq_vec[0], spi_irq || sslv_irq, poll_status};
+
     // Control and status registers
     control_registers ctrl_regs (
         .clk(clk),
         .rst(rst),
-        .wb_valid(wb_valid && ctrl_sel),
+        .wb_valid(wb_valid && ctrl_regs_sel),
         .wb_we(wb_we),
         .wb_addr(wb_addr[7:0]),
         .wb_data_in(wb_data_in),
@@ -224,8 +1121,17 @@ module user_proj_example #(
         .wb_ack(ctrl_ack),
         .spi_active(spi_active),
         .uart_active(uart_active),
-        .spi_irq(spi_irq),
-        .uart_irq(uart_irq)
+        .spi_clk_off(spi_clk_off),
+        .uart_clk_off(uart_clk_off),
+        .spi_irq(spi_irq || sslv_irq),
+        .uart_irq(uart_irq),
+        .uart_irq_vec({{(16-N_UART){1'b0}}, uart_irq_vec}),
+        .perf_evt(perf_evt),
+        .perf_lvl_rd(perf_lvl_rd),
+        .perf_lvl(bus_data_out[7:0]),
+        .status_snap(status_snap),
+        .snapshot_rd(snapshot_rd),
+        .control(control)
     );
 
 endmodule
@@ -242,26 +1148,135 @@ module control_registers (
     output reg wb_ack,
     input spi_active,
     input uart_active,
+    input spi_clk_off,
+    input uart_clk_off,
     input spi_irq,
-    input uart_irq
+    input uart_irq,
+    input [15:0] uart_irq_vec,
+    input [9:0] perf_evt,
+    input [3:0] perf_lvl_rd,
+    input [7:0] perf_lvl,
+    input [31:0] status_snap,
+    output snapshot_rd,
+    output [31:0] control
 );
 
     // Register addresses
     localparam STATUS_REG = 8'h00;
     localparam CONTROL_REG = 8'h04;
     localparam VERSION_REG = 8'h08;
+    localparam UART_IRQ_REG = 8'h0C;
+    localparam PERF_CTRL_REG = 8'h10;
+    localparam PERF_CNT_BASE = 8'h14;  // PERF_CNT_BASE + 4*i: counter i
+    localparam PERF_HWM_REG = 8'h3C;
+    localparam SNAPSHOT_REG = 8'h40;
+
+    // Performance counters, one per perf_evt bit
+    localparam NPERF = 10;
 
     // Control register bits
+    // [0] BRIDGE_SPI2UART : forward SPI RX FIFO into UART TX FIFO
+    // [1] BRIDGE_UART2SPI : forward UART RX FIFO into SPI TX FIFO
+    // [2] SPI_SLAVE       : SPI slave owns the SPI pads (with SPI_ENABLE)
+    // [3] STATUS_POLL     : refresh the SNAPSHOT_REG FIFO and error fields,
+    //                       one poll round per SNAPSHOT_REG read
+    // [4] SPI_CLK_GATE    : stop the SPI core clock while idle
+    // [5] UART_CLK_GATE   : stop each UART core clock while idle
+    // [8] LA_MAILBOX      : LA mailbox owns la_data_out (see la_mailbox)
+    // [15:12] CLK_IDLE    : idle time before stopping, 2^(n+4) ser_clk cycles
     reg [31:0] control_reg;
     reg [31:0] status_reg;
+    reg [31:0] snapshot_reg;
     reg [31:0] version_reg;
+    reg [31:0] uart_irq_reg;
+
+    assign control = control_reg;
 
     // Version register (read-only)
     assign version_reg = 32'h01000000; // Version 1.0.0.0
 
-    // Status register (read-only)
+    // Status register (read-only), sampled into a flop so the read mux
+    // starts from registered state
+    always @(posedge clk) begin
+        if (rst)
+            status_reg <= 32'h0;
+        else
+            status_reg <= {26'b0, uart_clk_off, spi_clk_off, uart_irq, spi_irq, uart_active, spi_active};
+    end
+
+    // Status snapshot (read-only), registered the same way. A read
+    // also starts a poll round for the next one.
+    assign snapshot_rd = wb_valid && !wb_ack && !wb_we && (wb_addr == SNAPSHOT_REG);
+
+    always @(posedge clk) begin
+        if (rst)
+            snapshot_reg <= 32'h0;
+        else
+            snapshot_reg <= status_snap;
+    end
+
+    // UART interrupt status (read-only): [15:0] pending channels,
+    // [19:16] lowest pending channel, [31] any channel pending
+    reg [3:0] uart_irq_first;
+    integer i;
+
     always @(*) begin
-        status_reg = {28'b0, uart_irq, spi_irq, uart_active, spi_active};
+        uart_irq_first = 4'h0;
+        for (i = 15; i >= 0; i = i - 1)
+            if (uart_irq_vec[i])
+                uart_irq_first = i[3:0];
+    end
+
+    always @(posedge clk) begin
+        if (rst)
+            uart_irq_reg <= 32'h0;
+        else
+            uart_irq_reg <= {|uart_irq_vec, 11'b0, uart_irq_first, uart_irq_vec};
+    end
+
+    // Performance counters. Live counters run freely; PERF_CTRL[0]
+    // copies every counter and the FIFO high-water marks into the
+    // readable snapshot and clears them in the same cycle. An event in
+    // that cycle is kept as the first count of the new interval.
+    reg [32*NPERF-1:0] perf_cnt;
+    reg [32*NPERF-1:0] perf_snap;
+    reg [31:0] perf_hwm;
+    reg [31:0] perf_hwm_snap;
+    integer k;
+
+    wire perf_snapshot = wb_valid && !wb_ack && wb_we &&
+                         (wb_addr == PERF_CTRL_REG) && wb_data_in[0];
+
+    wire [7:0] perf_cnt_idx = (wb_addr - PERF_CNT_BASE) >> 2;
+    wire perf_cnt_hit = (wb_addr >= PERF_CNT_BASE) && (perf_cnt_idx < NPERF);
+
+    always @(posedge clk) begin
+        if (rst) begin
+            perf_cnt <= {32*NPERF{1'b0}};
+            perf_snap <= {32*NPERF{1'b0}};
+            perf_hwm <= 32'h0;
+            perf_hwm_snap <= 32'h0;
+        end else begin
+            for (k = 0; k < NPERF; k = k + 1) begin
+                if (perf_snapshot)
+                    perf_cnt[32*k +: 32] <= {31'h0, perf_evt[k]};
+                else if (perf_evt[k])
+                    perf_cnt[32*k +: 32] <= perf_cnt[32*k +: 32] + 32'h1;
+            end
+
+            // [7:0] SPI RX, [15:8] SPI TX, [23:16] UART RX, [31:24] UART TX
+            for (k = 0; k < 4; k = k + 1) begin
+                if (perf_snapshot)
+                    perf_hwm[8*k +: 8] <= perf_lvl_rd[k] ? perf_lvl : 8'h0;
+                else if (perf_lvl_rd[k] && perf_lvl > perf_hwm[8*k +: 8])
+                    perf_hwm[8*k +: 8] <= perf_lvl;
+            end
+
+            if (perf_snapshot) begin
+                perf_snap <= perf_cnt;
+                perf_hwm_snap <= perf_hwm;
+            end
+        end
     end
 
     // Wishbone interface
@@ -287,7 +1302,10 @@ module control_registers (
                         STATUS_REG: wb_data_out <= status_reg;
                         CONTROL_REG: wb_data_out <= control_reg;
                         VERSION_REG: wb_data_out <= version_reg;
-                        default: wb_data_out <= 32'h0;
+                        UART_IRQ_REG: wb_data_out <= uart_irq_reg;
+                        PERF_HWM_REG: wb_data_out <= perf_hwm_snap;
+                        SNAPSHOT_REG: wb_data_out <= snapshot_reg;
+                        default: wb_data_out <= perf_cnt_hit ? perf_snap[32*perf_cnt_idx +: 32] : 32'h0;
                     endcase
                 end
             end
@@ -108,17 +108,25 @@ user_proj_example mprj (
     .la_data_out(la_data_out),
     .la_oenb (la_oenb),
 
-    // IO Pads - Map to GPIO pins 5-14 for SPI/UART functionality
-    // GPIO 5-14 correspond to io_in[12:3] in the wrapper mapping
-    // Our design uses: 5=SPI_MOSI, 6=SPI_MISO, 7=SPI_SCLK, 8=SPI_CSB, 9=UART_TX, 10=UART_RX, 11=SPI_LED, 12=UART_LED, 13=SPI_EN, 14=UART_EN
-    .io_in (io_in[14:5]),
-    .io_out(io_out[14:5]),
-    .io_oeb(io_oeb[14:5]),
+    // IO Pads - Map to GPIO pins 5-37
+    // Our design uses: 5=SPI_MOSI/QSPI_IO0, 6=SPI_MISO/QSPI_IO1, 7=SPI_SCLK, 8=SPI_CSB, 9=UART_TX, 10=UART_RX, 11=SPI_LED, 12=UART_LED, 13=SPI_EN, 14=UART_EN, 15=QSPI_IO2, 16=QSPI_IO3
+    .io_in (io_in[37:5]),
+    .io_out(io_out[37:5]),
+    .io_oeb(io_oeb[37:5]),
+
+    // SPI/UART core clock
+    .user_clock2(user_clock2),
 
     // IRQ
     .irq(user_irq)
 );
 
+`ifdef USER_PROJ_SDF
+// Mixed RTL/GL simulation (SIM=GL_UPRJ_SDF, verilog/dv/gl_uprj_sdf.makefile):
+// only the user_proj_example netlist is back-annotated
+initial $sdf_annotate(`USER_PROJ_SDF, mprj);
+`endif
+
 endmodule	// user_project_wrapper
 
 `default_nettype wire
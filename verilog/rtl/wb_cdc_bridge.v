@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * wb_cdc_bridge
+ *
+ * Carries single Wishbone accesses from clock domain A (slave
+ * side) to clock domain B (master side) with a two-phase
+ * (toggle) handshake. The request fields are captured in domain A
+ * and held stable until the matching acknowledge toggle returns,
+ * so only the toggle bits go through synchronisers; the wide
+ * address/data buses are bundled data and must be constrained
+ * as such (see the SDC).
+ *
+ *-------------------------------------------------------------
+ */
+
+module wb_cdc_bridge (
+    // Slave side (domain A)
+    input clk_a,
+    input rst_a,
+    input s_valid,
+    input s_we,
+    input [3:0] s_sel,
+    input [15:0] s_addr,
+    input [31:0] s_data_in,
+    output reg [31:0] s_data_out,
+    output reg s_ack,
+
+    // Master side (domain B)
+    input clk_b,
+    input rst_b,
+    output reg m_valid,
+    output reg m_we,
+    output reg [3:0] m_sel,
+    output reg [15:0] m_addr,
+    output reg [31:0] m_data_out,
+    input [31:0] m_data_in,
+    input m_ack
+);
+
+    // Domain A: request capture
+    reg req_tog_a;
+    reg busy_a;
+    reg ack_seen_a;
+    reg [15:0] addr_a;
+    reg [31:0] data_a;
+    reg [3:0] sel_a;
+    reg we_a;
+
+    // Domain B: response capture
+    reg ack_tog_b;
+    reg req_seen_b;
+    reg [31:0] rdata_b;
+
+    wire ack_tog_sync_a;
+    wire req_tog_sync_b;
+
+    cdc_sync #(.WIDTH(1)) ack_sync (
+        .clk(clk_a),
+        .rst(rst_a),
+        .d(ack_tog_b),
+        .q(ack_tog_sync_a)
+    );
+
+    cdc_sync #(.WIDTH(1)) req_sync (
+        .clk(clk_b),
+        .rst(rst_b),
+        .d(req_tog_a),
+        .q(req_tog_sync_b)
+    );
+
+    always @(posedge clk_a) begin
+        if (rst_a) begin
+            req_tog_a <= 1'b0;
+            busy_a <= 1'b0;
+            ack_seen_a <= 1'b0;
+            addr_a <= 16'h0;
+            data_a <= 32'h0;
+            sel_a <= 4'h0;
+            we_a <= 1'b0;
+            s_ack <= 1'b0;
+            s_data_out <= 32'h0;
+        end else begin
+            s_ack <= 1'b0;
+
+            if (!busy_a) begin
+                if (s_valid && !s_ack) begin
+                    addr_a <= s_addr;
+                    data_a <= s_data_in;
+                    sel_a <= s_sel;
+                    we_a <= s_we;
+                    req_tog_a <= ~req_tog_a;
+                    busy_a <= 1'b1;
+                end
+            end else if (ack_tog_sync_a != ack_seen_a) begin
+                ack_seen_a <= ack_tog_sync_a;
+                s_data_out <= rdata_b;
+                s_ack <= 1'b1;
+                busy_a <= 1'b0;
+            end
+        end
+    end
+
+    always @(posedge clk_b) begin
+        if (rst_b) begin
+            ack_tog_b <= 1'b0;
+            req_seen_b <= 1'b0;
+            rdata_b <= 32'h0;
+            m_valid <= 1'b0;
+            m_we <= 1'b0;
+            m_sel <= 4'h0;
+            m_addr <= 16'h0;
+            m_data_out <= 32'h0;
+        end else begin
+            if (!m_valid) begin
+                if (req_tog_sync_b != req_seen_b) begin
+                    req_seen_b <= req_tog_sync_b;
+                    m_valid <= 1'b1;
+                    m_we <= we_a;
+                    m_sel <= sel_a;
+                    m_addr <= addr_a;
+                    m_data_out <= data_a;
+                end
+            end else if (m_ack) begin
+                m_valid <= 1'b0;
+                rdata_b <= m_data_in;
+                ack_tog_b <= ~ack_tog_b;
+            end
+        end
+    end
+
+endmodule
+
+// Multi-bit level synchroniser (each bit synchronised independently)
+module cdc_sync #(
+    parameter WIDTH = 1
+)(
+    input clk,
+    input rst,
+    input [WIDTH-1:0] d,
+    output [WIDTH-1:0] q
+);
+
+    reg [WIDTH-1:0] meta;
+    reg [WIDTH-1:0] sync;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            meta <= {WIDTH{1'b0}};
+            sync <= {WIDTH{1'b0}};
+        end else begin
+            meta <= d;
+            sync <= meta;
+        end
+    end
+
+    assign q = sync;
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2020 Efabless Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// SPDX-License-Identifier: Apache-2.0
+
+`default_nettype none
+/*
+ *-------------------------------------------------------------
+ *
+ * wb_frontend
+ *
+ * Wishbone B4 pipelined-mode slave front end. The incoming
+ * request and its one-hot slave decode are registered, the
+ * registered request is held towards the slaves until one of
+ * them acks, and the response is registered back to the host.
+ * stall_o is raised while a request is still waiting on its
+ * slave, and the next request is accepted in the same cycle the
+ * current one completes, so slaves that ack in one cycle give
+ * back-to-back acks.
+ *
+ * Requests that decode to no slave are acked with zero data so
+ * a stray access can never hang the bus.
+ *
+ * With CLASSIC set, a request held on stb_i is only accepted
+ * once, which lets a classic (non-pipelined) master such as the
+ * Caravel management SoC drive the same front end.
+ *
+ *-------------------------------------------------------------
+ */
+
+module wb_frontend #(
+    parameter NSLV = 3,
+    parameter CLASSIC = 1
+)(
+    input clk,
+    input rst,
+
+    // Host side
+    input cyc_i,
+    input stb_i,
+    input we_i,
+    input [3:0] sel_i,
+    input [15:0] adr_i,
+    input [31:0] dat_i,
+    input [NSLV-1:0] dec_i,
+    output stall_o,
+    output reg ack_o,
+    output reg [31:0] dat_o,
+
+    // Registered request towards the slaves
+    output reg req_valid,
+    output reg req_we,
+    output reg [3:0] req_sel,
+    output reg [15:0] req_addr,
+    output reg [31:0] req_data,
+    output reg [NSLV-1:0] req_dec,
+    input rsp_ack,
+    input [31:0] rsp_data
+);
+
+    reg host_pending;
+
+    wire req_unmapped = (req_dec == {NSLV{1'b0}});
+    wire req_done = req_valid && (rsp_ack || req_unmapped);
+    wire accept = cyc_i && stb_i && !stall_o && !(CLASSIC && host_pending);
+
+    assign stall_o = req_valid && !req_done;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            ack_o <= 1'b0;
+            dat_o <= 32'h0;
+            req_valid <= 1'b0;
+            req_we <= 1'b0;
+            req_sel <= 4'h0;
+            req_addr <= 16'h0;
+            req_data <= 32'h0;
+            req_dec <= {NSLV{1'b0}};
+            host_pending <= 1'b0;
+        end else begin
+            ack_o <= req_done;
+            if (req_done)
+                dat_o <= req_unmapped ? 32'h0 : rsp_data;
+
+            if (accept) begin
+                req_valid <= 1'b1;
+                req_we <= we_i;
+                req_sel <= sel_i;
+                req_addr <= adr_i;
+                req_data <= dat_i;
+                req_dec <= dec_i;
+            end else if (req_done) begin
+                req_valid <= 1'b0;
+            end
+
+            // A classic master keeps stb_i up until it sees ack_o
+            if (CLASSIC)
+                host_pending <= host_pending ? !ack_o : accept;
+        end
+    end
+
+endmodule
+
+`default_nettype wire